@@ -11,26 +11,197 @@
 #include <deque>
 #include <iomanip>
 #include <sstream>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <unordered_set>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <set>
+#include <tuple>
+#include <type_traits>
+#include <charconv>
+#include <cstdlib>
+#include <new>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define FM_X86_SIMD 1
+#endif
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#endif
 
 using namespace std;
 namespace fs = std::filesystem;
 
+// Heap allocations made so far. Nothing in the program counts them; a
+// build that replaces operator new (bench/allocation_bench.cpp) bumps it,
+// and the catalog's AllocationMeters then report allocations per operation.
+atomic<size_t> heapAllocations(0);
+
 // File type classification
 enum FileType {
     DOCUMENT, IMAGE, AUDIO, VIDEO, ARCHIVE, DIRECTORY, OTHER
 };
 
-// Mapping of file extensions to their types
-map<string, FileType> fileTypeMap = {
-    {".txt", DOCUMENT}, {".pdf", DOCUMENT}, 
-    {".doc", DOCUMENT}, {".docx", DOCUMENT},
-    {".jpg", IMAGE}, {".png", IMAGE},
-    {".gif", IMAGE}, {".bmp", IMAGE},
-    {".mp3", AUDIO}, {".wav", AUDIO},
-    {".mp4", VIDEO}, {".mov", VIDEO}, 
-    {".zip", ARCHIVE}, {".rar", ARCHIVE}
+// Known file extensions (lowercase, without the dot, at most 8 characters)
+struct ExtensionType {
+    const char* extension;
+    FileType type;
+};
+
+constexpr ExtensionType EXTENSION_TYPES[] = {
+    // Documents, including plain-text data and source files
+    {"txt", DOCUMENT}, {"pdf", DOCUMENT}, {"doc", DOCUMENT}, {"docx", DOCUMENT}, {"odt", DOCUMENT},
+    {"rtf", DOCUMENT}, {"md", DOCUMENT}, {"markdown", DOCUMENT}, {"rst", DOCUMENT}, {"tex", DOCUMENT},
+    {"xls", DOCUMENT}, {"xlsx", DOCUMENT}, {"ods", DOCUMENT}, {"csv", DOCUMENT}, {"tsv", DOCUMENT},
+    {"ppt", DOCUMENT}, {"pptx", DOCUMENT}, {"odp", DOCUMENT}, {"epub", DOCUMENT}, {"mobi", DOCUMENT},
+    {"pages", DOCUMENT}, {"numbers", DOCUMENT}, {"key", DOCUMENT}, {"log", DOCUMENT}, {"json", DOCUMENT},
+    {"xml", DOCUMENT}, {"yaml", DOCUMENT}, {"yml", DOCUMENT}, {"toml", DOCUMENT}, {"ini", DOCUMENT},
+    {"cfg", DOCUMENT}, {"conf", DOCUMENT}, {"html", DOCUMENT}, {"htm", DOCUMENT}, {"css", DOCUMENT},
+    {"js", DOCUMENT}, {"jsx", DOCUMENT}, {"tsx", DOCUMENT}, {"c", DOCUMENT}, {"h", DOCUMENT},
+    {"cpp", DOCUMENT}, {"hpp", DOCUMENT}, {"cc", DOCUMENT}, {"cxx", DOCUMENT}, {"hh", DOCUMENT},
+    {"py", DOCUMENT}, {"rb", DOCUMENT}, {"java", DOCUMENT}, {"kt", DOCUMENT}, {"go", DOCUMENT},
+    {"rs", DOCUMENT}, {"swift", DOCUMENT}, {"cs", DOCUMENT}, {"php", DOCUMENT}, {"sh", DOCUMENT},
+    {"bat", DOCUMENT}, {"ps1", DOCUMENT}, {"sql", DOCUMENT}, {"lua", DOCUMENT}, {"pl", DOCUMENT},
+    {"scala", DOCUMENT}, {"dart", DOCUMENT}, {"vue", DOCUMENT},
+    // Images
+    {"jpg", IMAGE}, {"jpeg", IMAGE}, {"jpe", IMAGE}, {"png", IMAGE}, {"gif", IMAGE}, {"bmp", IMAGE},
+    {"tif", IMAGE}, {"tiff", IMAGE}, {"webp", IMAGE}, {"svg", IMAGE}, {"ico", IMAGE}, {"heic", IMAGE},
+    {"heif", IMAGE}, {"avif", IMAGE}, {"jxl", IMAGE}, {"raw", IMAGE}, {"cr2", IMAGE}, {"cr3", IMAGE},
+    {"nef", IMAGE}, {"arw", IMAGE}, {"dng", IMAGE}, {"orf", IMAGE}, {"psd", IMAGE}, {"ai", IMAGE},
+    {"eps", IMAGE}, {"tga", IMAGE}, {"xcf", IMAGE},
+    // Audio
+    {"mp3", AUDIO}, {"wav", AUDIO}, {"flac", AUDIO}, {"aac", AUDIO}, {"ogg", AUDIO}, {"oga", AUDIO},
+    {"opus", AUDIO}, {"m4a", AUDIO}, {"wma", AUDIO}, {"aiff", AUDIO}, {"aif", AUDIO}, {"alac", AUDIO},
+    {"mid", AUDIO}, {"midi", AUDIO}, {"amr", AUDIO}, {"ape", AUDIO}, {"wv", AUDIO},
+    // Video
+    {"mp4", VIDEO}, {"m4v", VIDEO}, {"mov", VIDEO}, {"mkv", VIDEO}, {"avi", VIDEO}, {"wmv", VIDEO},
+    {"flv", VIDEO}, {"webm", VIDEO}, {"mpg", VIDEO}, {"mpeg", VIDEO}, {"3gp", VIDEO}, {"ogv", VIDEO},
+    {"vob", VIDEO}, {"m2ts", VIDEO}, {"mts", VIDEO},
+    // Archives and disk images
+    {"zip", ARCHIVE}, {"rar", ARCHIVE}, {"7z", ARCHIVE}, {"tar", ARCHIVE}, {"gz", ARCHIVE},
+    {"tgz", ARCHIVE}, {"bz2", ARCHIVE}, {"tbz2", ARCHIVE}, {"xz", ARCHIVE}, {"txz", ARCHIVE},
+    {"zst", ARCHIVE}, {"lz", ARCHIVE}, {"lzma", ARCHIVE}, {"lz4", ARCHIVE}, {"cab", ARCHIVE},
+    {"iso", ARCHIVE}, {"dmg", ARCHIVE}, {"jar", ARCHIVE}, {"war", ARCHIVE}, {"apk", ARCHIVE},
+    {"deb", ARCHIVE}, {"rpm", ARCHIVE}, {"cpio", ARCHIVE}
+};
+
+// Extension packed little-endian into a 64-bit key, lowercasing ASCII letters.
+// Returns 0 for anything that cannot be a table key.
+constexpr uint64_t packExtension(const char* text, size_t length) {
+    if (length == 0 || length > 8) return 0;
+    uint64_t key = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 'A' && c <= 'Z') c = static_cast<unsigned char>(c - 'A' + 'a');
+        key |= static_cast<uint64_t>(c) << (8 * i);
+    }
+    return key;
+}
+
+constexpr uint64_t mixExtension(uint64_t key, uint64_t seed) {
+    key ^= seed * 0x9E3779B97F4A7C15ull;
+    key ^= key >> 31;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 29;
+    return key;
+}
+
+// Perfect hash over EXTENSION_TYPES, built at compile time by hash and
+// displace: keys are grouped into buckets by one hash, then each bucket,
+// largest first, gets the smallest displacement that sends all its keys to
+// free slots. A lookup is two hashes and one key comparison.
+struct ExtensionTable {
+    static constexpr size_t KEYS = sizeof(EXTENSION_TYPES) / sizeof(EXTENSION_TYPES[0]);
+    static constexpr size_t BUCKETS = 64;
+    static constexpr size_t SLOTS = 512;
+
+    uint64_t keys[SLOTS] = {};
+    FileType types[SLOTS] = {};
+    uint16_t displacement[BUCKETS] = {};
+
+    static constexpr size_t bucketOf(uint64_t key) {
+        return mixExtension(key, 0) % BUCKETS;
+    }
+
+    static constexpr size_t slotOf(uint64_t key, uint16_t displace) {
+        return mixExtension(key, displace + 1) % SLOTS;
+    }
+
+    constexpr ExtensionTable() {
+        size_t bucketSize[BUCKETS] = {};
+        for (size_t i = 0; i < KEYS; i++) {
+            bucketSize[bucketOf(extensionKey(i))]++;
+        }
+        size_t largest = 0;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            largest = bucketSize[b] > largest ? bucketSize[b] : largest;
+        }
+
+        for (size_t size = largest; size > 0; size--) {
+            for (size_t b = 0; b < BUCKETS; b++) {
+                if (bucketSize[b] != size) continue;
+                uint16_t displace = 0;
+                while (!fits(b, displace)) {
+                    // A duplicate key or a full table makes this fail to compile
+                    if (++displace == 0xFFFF) throw "no perfect hash for the extension table";
+                }
+                displacement[b] = displace;
+                for (size_t i = 0; i < KEYS; i++) {
+                    uint64_t key = extensionKey(i);
+                    if (bucketOf(key) != b) continue;
+                    keys[slotOf(key, displace)] = key;
+                    types[slotOf(key, displace)] = EXTENSION_TYPES[i].type;
+                }
+            }
+        }
+    }
+
+    static constexpr uint64_t extensionKey(size_t i) {
+        const char* text = EXTENSION_TYPES[i].extension;
+        size_t length = 0;
+        while (text[length]) length++;
+        return packExtension(text, length);
+    }
+
+    // Whether every key of bucket b lands on a distinct free slot
+    constexpr bool fits(size_t b, uint16_t displace) const {
+        bool taken[SLOTS] = {};
+        for (size_t i = 0; i < KEYS; i++) {
+            uint64_t key = extensionKey(i);
+            if (bucketOf(key) != b) continue;
+            size_t slot = slotOf(key, displace);
+            if (keys[slot] != 0 || taken[slot]) return false;
+            taken[slot] = true;
+        }
+        return true;
+    }
+
+    FileType find(uint64_t key) const {
+        size_t slot = slotOf(key, displacement[bucketOf(key)]);
+        return key != 0 && keys[slot] == key ? types[slot] : OTHER;
+    }
 };
 
+constexpr ExtensionTable EXTENSION_TABLE;
+
 // Helper function to format time
 string formatTime(time_t time) {
     if (time == 0) return "Unknown";
@@ -40,20 +211,679 @@ string formatTime(time_t time) {
     return string(buffer);
 }
 
-// Determine file type based on extension
-FileType getFileType(const string& filename) {
-    if (fs::is_directory(filename)) {
-        return DIRECTORY;
+// Determine file type based on extension alone; no allocation or syscall
+FileType getFileTypeFromExtension(string_view filename) {
+    size_t dotPos = filename.find_last_of("./\\");
+    if (dotPos == string::npos || filename[dotPos] != '.') return OTHER;
+    string_view ext = filename.substr(dotPos + 1);
+    return EXTENSION_TABLE.find(packExtension(ext.data(), ext.size()));
+}
+
+// Determine file type from a status the caller already has
+FileType getFileType(string_view filename, const fs::file_status& status) {
+    return fs::is_directory(status) ? DIRECTORY : getFileTypeFromExtension(filename);
+}
+
+// Directory iteration usually knows the entry type already (d_type), so this
+// only stats when the platform did not report it
+FileType getFileType(const fs::directory_entry& entry) {
+    error_code ec;
+    return entry.is_directory(ec) ? DIRECTORY : getFileTypeFromExtension(entry.path().native());
+}
+
+// Determine file type based on extension; stats the path to spot directories
+FileType getFileType(string_view filename) {
+    error_code ec;
+    return getFileType(filename, fs::status(fs::path(filename), ec));
+}
+
+// Size of a regular file on disk, 0 for directories or unreadable paths
+size_t fileSizeOnDisk(string_view filename) {
+    error_code ec;
+    fs::path path(filename);
+    if (!fs::is_regular_file(path, ec)) return 0;
+    uintmax_t size = fs::file_size(path, ec);
+    return ec ? 0 : static_cast<size_t>(size);
+}
+
+// Read-only, zero-copy view of a file's bytes. Large files are memory-mapped;
+// small ones are read with a single pre-sized read() into an owned buffer.
+struct MappedFile {
+    static constexpr size_t MMAP_THRESHOLD = 64 * 1024;
+
+    const char* data;
+    size_t length;
+    bool mapped;
+    string buffer;
+
+    MappedFile() : data(nullptr), length(0), mapped(false) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapped) munmap(const_cast<char*>(data), length);
+#endif
+    }
+
+    string_view view() const { return string_view(data, length); }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    // Never returns null; unreadable files yield an empty view
+    static shared_ptr<const MappedFile> open(string_view name) {
+        auto file = make_shared<MappedFile>();
+        string filename(name);
+#ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return file;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            size_t fileSize = static_cast<size_t>(info.st_size);
+            if (fileSize >= MMAP_THRESHOLD) {
+                void* address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address != MAP_FAILED) {
+                    madvise(address, fileSize, MADV_SEQUENTIAL);
+                    file->data = static_cast<const char*>(address);
+                    file->length = fileSize;
+                    file->mapped = true;
+                }
+            }
+            if (!file->mapped) {
+                file->buffer.resize(fileSize);
+                size_t total = 0;
+                while (total < fileSize) {
+                    ssize_t n = ::read(fd, &file->buffer[total], fileSize - total);
+                    if (n <= 0) break;
+                    total += static_cast<size_t>(n);
+                }
+                file->buffer.resize(total);
+                file->data = file->buffer.data();
+                file->length = total;
+            }
+        }
+        ::close(fd);
+#else
+        ifstream in(filename, ios::binary | ios::ate);
+        if (in) {
+            file->buffer.resize(static_cast<size_t>(in.tellg()));
+            in.seekg(0);
+            in.read(&file->buffer[0], file->buffer.size());
+            file->buffer.resize(static_cast<size_t>(in.gcount()));
+            file->data = file->buffer.data();
+            file->length = file->buffer.size();
+        }
+#endif
+        return file;
+    }
+};
+
+long countLines(string_view content) {
+    long lineCount = count(content.begin(), content.end(), '\n');
+    if (!content.empty() && content.back() != '\n') lineCount++;
+    return lineCount;
+}
+
+// Disk modification stamp used to tell whether persisted data is stale
+long long fileModifiedStamp(string_view filename) {
+    error_code ec;
+    auto stamp = fs::last_write_time(fs::path(filename), ec);
+    return ec ? 0 : static_cast<long long>(stamp.time_since_epoch().count());
+}
+
+// Magic numbers recognised by content sniffing. An optional second pattern
+// must also match, e.g. the form type inside a RIFF or ISO media container.
+// Earlier entries win, so specific signatures come before generic ones.
+struct MagicSignature {
+    uint16_t offset;
+    const char* bytes;
+    uint8_t length;
+    FileType type;
+    uint16_t secondOffset;
+    const char* second;
+    uint8_t secondLength;
+
+    constexpr MagicSignature(uint16_t offset, const char* bytes, uint8_t length, FileType type,
+                             uint16_t secondOffset = 0, const char* second = "", uint8_t secondLength = 0) :
+        offset(offset), bytes(bytes), length(length), type(type),
+        secondOffset(secondOffset), second(second), secondLength(secondLength) {}
+};
+
+constexpr MagicSignature MAGIC_SIGNATURES[] = {
+    // Documents
+    {0, "%PDF-", 5, DOCUMENT},
+    {0, "{\\rtf", 5, DOCUMENT},
+    {0, "\xD0\xCF\x11\xE0\xA1\xB1\x1A\xE1", 8, DOCUMENT}, // OLE2: doc, xls, ppt
+    // Images
+    {0, "\x89PNG\r\n\x1A\n", 8, IMAGE},
+    {0, "\xFF\xD8\xFF", 3, IMAGE},
+    {0, "GIF87a", 6, IMAGE},
+    {0, "GIF89a", 6, IMAGE},
+    {0, "BM", 2, IMAGE, 6, "\0\0\0\0", 4},
+    {0, "II*\0", 4, IMAGE},
+    {0, "MM\0*", 4, IMAGE},
+    {0, "RIFF", 4, IMAGE, 8, "WEBP", 4},
+    {0, "8BPS", 4, IMAGE},
+    {0, "\xFF\x0A", 2, IMAGE}, // JPEG XL codestream
+    {4, "ftypheic", 8, IMAGE},
+    {4, "ftypheix", 8, IMAGE},
+    {4, "ftypmif1", 8, IMAGE},
+    {4, "ftypavif", 8, IMAGE},
+    // Audio
+    {0, "ID3", 3, AUDIO},
+    {0, "\xFF\xFB", 2, AUDIO},
+    {0, "\xFF\xF3", 2, AUDIO},
+    {0, "\xFF\xF2", 2, AUDIO},
+    {0, "fLaC", 4, AUDIO},
+    {0, "OggS", 4, AUDIO},
+    {0, "RIFF", 4, AUDIO, 8, "WAVE", 4},
+    {0, "FORM", 4, AUDIO, 8, "AIFF", 4},
+    {0, "FORM", 4, AUDIO, 8, "AIFC", 4},
+    {0, "MThd\0\0\0\x06", 8, AUDIO},
+    {0, "#!AMR", 5, AUDIO},
+    {4, "ftypM4A ", 8, AUDIO},
+    // Video
+    {0, "\x1A\x45\xDF\xA3", 4, VIDEO}, // Matroska, WebM
+    {0, "RIFF", 4, VIDEO, 8, "AVI ", 4},
+    {0, "FLV\x01", 4, VIDEO},
+    {0, "\0\0\x01\xBA", 4, VIDEO},
+    {0, "\0\0\x01\xB3", 4, VIDEO},
+    {0, "\x30\x26\xB2\x75\x8E\x66\xCF\x11", 8, VIDEO}, // ASF: wmv, wma
+    {4, "ftyp", 4, VIDEO}, // Any other ISO media file: mp4, mov, 3gp
+    // Archives
+    {0, "PK\x03\x04", 4, ARCHIVE},
+    {0, "PK\x05\x06", 4, ARCHIVE},
+    {0, "Rar!\x1A\x07", 6, ARCHIVE},
+    {0, "7z\xBC\xAF\x27\x1C", 6, ARCHIVE},
+    {0, "\x1F\x8B", 2, ARCHIVE},
+    {0, "BZh", 3, ARCHIVE},
+    {0, "\xFD" "7zXZ\0", 6, ARCHIVE},
+    {0, "\x28\xB5\x2F\xFD", 4, ARCHIVE},
+    {0, "\x04\x22\x4D\x18", 4, ARCHIVE},
+    {0, "MSCF", 4, ARCHIVE},
+    {0, "!<arch>\n", 8, ARCHIVE},
+    {0, "\xED\xAB\xEE\xDB", 4, ARCHIVE},
+    {257, "ustar", 5, ARCHIVE}
+};
+
+// Matches a file header against every signature in one pass: signatures at
+// offset 0 are bucketed by their first byte at compile time, so a header is
+// only compared with the few that can start with its first byte, plus the
+// handful that sit further in.
+struct MagicMatcher {
+    static constexpr size_t COUNT = sizeof(MAGIC_SIGNATURES) / sizeof(MAGIC_SIGNATURES[0]);
+    static constexpr size_t LATE_BUCKET = 256; // Signatures with a non-zero offset
+    static constexpr size_t HEADER_BYTES = 512; // Enough to reach every signature
+
+    uint16_t order[COUNT] = {}; // Signature indexes grouped by bucket, in table order
+    uint16_t bucketStart[LATE_BUCKET + 2] = {};
+
+    static constexpr size_t bucketOf(const MagicSignature& signature) {
+        return signature.offset == 0 ? static_cast<unsigned char>(signature.bytes[0]) : LATE_BUCKET;
+    }
+
+    constexpr MagicMatcher() {
+        for (size_t i = 0; i < COUNT; i++) {
+            bucketStart[bucketOf(MAGIC_SIGNATURES[i]) + 1]++;
+        }
+        for (size_t b = 1; b < LATE_BUCKET + 2; b++) {
+            bucketStart[b] += bucketStart[b - 1];
+        }
+        uint16_t filled[LATE_BUCKET + 1] = {};
+        for (size_t i = 0; i < COUNT; i++) {
+            size_t b = bucketOf(MAGIC_SIGNATURES[i]);
+            order[bucketStart[b] + filled[b]++] = static_cast<uint16_t>(i);
+        }
+    }
+
+    static bool matches(const unsigned char* header, size_t length, size_t offset,
+                        const char* bytes, size_t count) {
+        return offset + count <= length && memcmp(header + offset, bytes, count) == 0;
+    }
+
+    FileType match(const unsigned char* header, size_t length) const {
+        if (length == 0) return OTHER;
+        for (size_t b : {static_cast<size_t>(header[0]), LATE_BUCKET}) {
+            for (size_t i = bucketStart[b]; i < bucketStart[b + 1]; i++) {
+                const MagicSignature& signature = MAGIC_SIGNATURES[order[i]];
+                if (matches(header, length, signature.offset, signature.bytes, signature.length) &&
+                    matches(header, length, signature.secondOffset, signature.second, signature.secondLength)) {
+                    return signature.type;
+                }
+            }
+        }
+        return OTHER;
+    }
+};
+
+constexpr MagicMatcher MAGIC_MATCHER;
+
+// No NUL bytes and almost no other control characters; UTF-8 passes
+bool looksLikeText(const unsigned char* header, size_t length) {
+    size_t controls = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = header[i];
+        if (c == 0) return false;
+        if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != '\b' && c != 0x1B) {
+            controls++;
+        }
+    }
+    return length > 0 && controls * 32 <= length;
+}
+
+// Containers that hold audio or video alike: Ogg, Matroska/WebM, ISO media
+// (mp4, m4a, mov) and ASF (wmv, wma). Their magic cannot tell the two apart.
+bool isMediaContainer(const unsigned char* header, size_t length) {
+    return MagicMatcher::matches(header, length, 0, "OggS", 4) ||
+           MagicMatcher::matches(header, length, 0, "\x1A\x45\xDF\xA3", 4) ||
+           MagicMatcher::matches(header, length, 4, "ftyp", 4) ||
+           MagicMatcher::matches(header, length, 0, "\x30\x26\xB2\x75\x8E\x66\xCF\x11", 8);
+}
+
+// Combine the extension's verdict with the file's first bytes. A signature
+// overrides a wrong extension, except for containers whose extension is the
+// more specific answer: docx/epub are zip files, .ai is a PDF, and a media
+// container keeps whichever of audio or video its extension names, so .m4a
+// stays audio and .ogv stays video. Text only decides when the extension
+// says nothing.
+FileType sniffFileType(const unsigned char* header, size_t length, FileType byExtension) {
+    FileType sniffed = MAGIC_MATCHER.match(header, length);
+    if (sniffed == OTHER) {
+        return (byExtension == OTHER && looksLikeText(header, length)) ? DOCUMENT : byExtension;
+    }
+    if (byExtension == OTHER || byExtension == sniffed) return sniffed;
+    bool media = (sniffed == AUDIO || sniffed == VIDEO) && (byExtension == AUDIO || byExtension == VIDEO);
+    bool container = (sniffed == ARCHIVE && byExtension == DOCUMENT) ||
+                     (sniffed == DOCUMENT && byExtension == IMAGE) ||
+                     (media && isMediaContainer(header, length));
+    return container ? byExtension : sniffed;
+}
+
+// Read up to capacity bytes from the start of a file; -1 if it cannot be opened
+long readFileHeader(string_view name, unsigned char* buffer, size_t capacity) {
+    string filename(name);
+#ifndef _WIN32
+    int flags = O_RDONLY | O_CLOEXEC;
+#ifdef O_NOATIME
+    // Classifying a catalog should not dirty every inode's access time
+    int fd = ::open(filename.c_str(), flags | O_NOATIME);
+    if (fd < 0 && errno == EPERM) fd = ::open(filename.c_str(), flags);
+#else
+    int fd = ::open(filename.c_str(), flags);
+#endif
+    if (fd < 0) return -1;
+    size_t total = 0;
+    while (total < capacity) {
+        ssize_t n = ::pread(fd, buffer + total, capacity - total, static_cast<off_t>(total));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        total += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    return static_cast<long>(total);
+#else
+    ifstream in(filename, ios::binary);
+    if (!in) return -1;
+    in.read(reinterpret_cast<char*>(buffer), static_cast<streamsize>(capacity));
+    return static_cast<long>(in.gcount());
+#endif
+}
+
+// Classify a regular file from its extension and first bytes; unreadable
+// files keep the extension's answer
+FileType detectFileType(string_view filename) {
+    FileType byExtension = getFileTypeFromExtension(filename);
+    unsigned char header[MagicMatcher::HEADER_BYTES];
+    long length = readFileHeader(filename, header, sizeof(header));
+    if (length <= 0) return byExtension;
+    return sniffFileType(header, static_cast<size_t>(length), byExtension);
+}
+
+// LEB128-style variable-length integers for the compact on-disk formats
+void writeVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const char*& cursor, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; cursor < end && shift < 64; shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(*cursor++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+void writeBytes(string& out, string_view bytes) {
+    writeVarint(out, bytes.size());
+    out.append(bytes.data(), bytes.size());
+}
+
+bool readBytes(const char*& cursor, const char* end, string& bytes) {
+    uint64_t length;
+    if (!readVarint(cursor, end, length) || length > static_cast<uint64_t>(end - cursor)) return false;
+    bytes.assign(cursor, length);
+    cursor += length;
+    return true;
+}
+
+uint32_t crc32(string_view data) {
+    static const auto table = [] {
+        array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (unsigned char byte : data) {
+        crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+#ifndef _WIN32
+bool writeAll(int fd, string_view data) {
+    while (!data.empty()) {
+        ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+// Make a completed rename durable
+void syncParentDirectory(const string& path) {
+    string parent = fs::path(path).parent_path().string();
+    int fd = ::open(parent.empty() ? "." : parent.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+}
+#endif
+
+// Replace path with data so that readers see either the old or the new file,
+// never a partial one: write a temp file, fsync it, then rename it over path.
+bool writeFileAtomically(const string& path, string_view data) {
+    string tempPath = path + ".tmp";
+#ifndef _WIN32
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, data) && fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tempPath.c_str(), path.c_str()) != 0) {
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    syncParentDirectory(path);
+    return true;
+#else
+    {
+        ofstream file(tempPath, ios::binary | ios::trunc);
+        if (!file.write(data.data(), data.size())) return false;
+    }
+    error_code ec;
+    fs::rename(tempPath, path, ec);
+    return !ec;
+#endif
+}
+
+// Framed log records: varint length, payload, then the payload's CRC32 in
+// little-endian order. The first payload byte is the record type.
+void appendFramedRecord(string& out, string_view record) {
+    writeVarint(out, record.size());
+    out.append(record.data(), record.size());
+    uint32_t checksum = crc32(record);
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((checksum >> shift) & 0xFF));
+    }
+}
+
+// Calls visit(type, body) for each intact record from offset on and returns
+// where the valid prefix ends; a torn or corrupt record stops the scan.
+template <typename Visit>
+size_t scanFramedRecords(string_view data, size_t offset, Visit visit) {
+    const char* end = data.data() + data.size();
+    while (offset < data.size()) {
+        const char* cursor = data.data() + offset;
+        uint64_t length;
+        if (!readVarint(cursor, end, length) || length == 0) break;
+        // Compared against what is left, so a corrupt length near 2^64
+        // cannot wrap around the check
+        uint64_t remaining = static_cast<uint64_t>(end - cursor);
+        if (length > remaining || remaining - length < 4) break;
+        string_view payload(cursor, length);
+        const unsigned char* stored = reinterpret_cast<const unsigned char*>(cursor + length);
+        uint32_t checksum = stored[0] | (stored[1] << 8) | (stored[2] << 16) |
+                            (static_cast<uint32_t>(stored[3]) << 24);
+        if (checksum != crc32(payload)) break;
+
+        visit(payload[0], payload.substr(1));
+        offset = (cursor + length + 4) - data.data();
+    }
+    return offset;
+}
+
+// Copy a regular file's bytes into a new file at `to`, keeping its permission
+// bits. On Linux this first tries a reflink (FICLONE), which shares extents on
+// filesystems such as btrfs and XFS, then copy_file_range, which copies inside
+// the kernel, and only then a plain read/write loop.
+bool copyFileContents(const string& from, const string& to) {
+#ifndef _WIN32
+    int source = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (source < 0) return false;
+    struct stat info;
+    if (fstat(source, &info) != 0) {
+        ::close(source);
+        return false;
+    }
+    int target = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 07777);
+    if (target < 0) {
+        ::close(source);
+        return false;
+    }
+
+    bool done = false, failed = false;
+#if defined(__linux__) && defined(FICLONE)
+    done = ioctl(target, FICLONE, source) == 0;
+#endif
+#ifdef __linux__
+    if (!done) {
+        off_t remaining = info.st_size;
+        while (remaining > 0) {
+            ssize_t copied = copy_file_range(source, nullptr, target, nullptr, static_cast<size_t>(remaining), 0);
+            if (copied < 0 && errno == EINTR) continue;
+            if (copied <= 0) break;
+            remaining -= copied;
+        }
+        done = remaining == 0;
+        // Not supported here: start over with plain copies
+        if (!done && (lseek(source, 0, SEEK_SET) != 0 || ftruncate(target, 0) != 0 ||
+                      lseek(target, 0, SEEK_SET) != 0)) {
+            failed = true;
+        }
+    }
+#endif
+    if (!done && !failed) {
+        vector<char> buffer(1 << 20);
+        while (true) {
+            ssize_t readBytes = ::read(source, buffer.data(), buffer.size());
+            if (readBytes < 0 && errno == EINTR) continue;
+            if (readBytes < 0) {
+                failed = true;
+                break;
+            }
+            if (readBytes == 0) break;
+            if (!writeAll(target, string_view(buffer.data(), static_cast<size_t>(readBytes)))) {
+                failed = true;
+                break;
+            }
+        }
+        done = !failed;
+    }
+    ::close(source);
+    if (::close(target) != 0) done = false;
+    if (!done) ::unlink(to.c_str());
+    return done;
+#else
+    error_code ec;
+    return fs::copy_file(from, to, ec);
+#endif
+}
+
+// Move a file or directory. Within one filesystem this is a single rename
+// whatever the size; across devices the data is copied and the source removed.
+void moveEntry(const string& from, const string& to) {
+    error_code ec;
+    fs::rename(from, to, ec);
+    if (!ec) return;
+    if (ec != errc::cross_device_link) {
+        throw fs::filesystem_error("rename", from, to, ec);
+    }
+
+    if (fs::is_directory(from)) {
+        fs::copy(from, to, fs::copy_options::recursive);
+        fs::remove_all(from);
+    } else {
+        if (!copyFileContents(from, to)) {
+            throw fs::filesystem_error("copy", from, to, make_error_code(errc::io_error));
+        }
+        fs::remove(from);
+    }
+}
+
+// Substring search kernels. Each counts the non-overlapping occurrences of
+// needle in haystack and records up to offsetLimit match offsets.
+typedef size_t (*SearchKernel)(string_view haystack, string_view needle,
+                               vector<size_t>* offsets, size_t offsetLimit);
+
+struct MatchRecorder {
+    size_t count = 0;
+    size_t nextStart = 0; // Matches may not start before this offset
+    vector<size_t>* offsets;
+    size_t offsetLimit;
+
+    MatchRecorder(vector<size_t>* out, size_t limit) : offsets(out), offsetLimit(limit) {}
+
+    void record(size_t position, size_t needleLength) {
+        count++;
+        nextStart = position + needleLength;
+        if (offsets && offsets->size() < offsetLimit) offsets->push_back(position);
+    }
+};
+
+// Scalar tail shared by every kernel: memchr for the first byte, memcmp the rest
+void scanScalar(string_view haystack, string_view needle, size_t from, MatchRecorder& matches) {
+    const char* base = haystack.data();
+    size_t n = needle.size();
+    size_t position = max(from, matches.nextStart);
+
+    while (position + n <= haystack.size()) {
+        const void* hit = memchr(base + position, needle[0], haystack.size() - n + 1 - position);
+        if (!hit) break;
+        position = static_cast<const char*>(hit) - base;
+        if (memcmp(base + position + 1, needle.data() + 1, n - 1) == 0) {
+            matches.record(position, n);
+            position += n;
+        } else {
+            position++;
+        }
+    }
+}
+
+size_t searchScalar(string_view haystack, string_view needle, vector<size_t>* offsets, size_t offsetLimit) {
+    if (needle.empty() || needle.size() > haystack.size()) return 0;
+    MatchRecorder matches(offsets, offsetLimit);
+    scanScalar(haystack, needle, 0, matches);
+    return matches.count;
+}
+
+#ifdef FM_X86_SIMD
+// Candidate positions are those whose first and last bytes both match the
+// needle's; only those are verified with memcmp.
+inline void verifyCandidates(unsigned mask, size_t blockStart, string_view haystack,
+                             string_view needle, MatchRecorder& matches) {
+    size_t n = needle.size();
+    while (mask) {
+        size_t position = blockStart + __builtin_ctz(mask);
+        mask &= mask - 1;
+        if (position < matches.nextStart) continue;
+        if (n <= 2 || memcmp(haystack.data() + position + 1, needle.data() + 1, n - 2) == 0) {
+            matches.record(position, n);
+        }
+    }
+}
+
+size_t searchSse2(string_view haystack, string_view needle, vector<size_t>* offsets, size_t offsetLimit) {
+    size_t n = needle.size();
+    if (n == 0 || n > haystack.size()) return 0;
+
+    MatchRecorder matches(offsets, offsetLimit);
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[n - 1]);
+    const char* base = haystack.data();
+
+    size_t i = 0;
+    for (; i + 16 + n - 1 <= haystack.size(); i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + i + n - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst),
+                                                        _mm_cmpeq_epi8(last, blockLast)));
+        verifyCandidates(mask, i, haystack, needle, matches);
     }
+    scanScalar(haystack, needle, i, matches);
+    return matches.count;
+}
 
-    size_t dotPos = filename.find_last_of('.');
-    if (dotPos != string::npos) {
-        string ext = filename.substr(dotPos);
-        transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-        auto it = fileTypeMap.find(ext);
-        if (it != fileTypeMap.end()) return it->second;
+__attribute__((target("avx2")))
+size_t searchAvx2(string_view haystack, string_view needle, vector<size_t>* offsets, size_t offsetLimit) {
+    size_t n = needle.size();
+    if (n == 0 || n > haystack.size()) return 0;
+
+    MatchRecorder matches(offsets, offsetLimit);
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+    const char* base = haystack.data();
+
+    size_t i = 0;
+    for (; i + 32 + n - 1 <= haystack.size(); i += 32) {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(base + i + n - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast))));
+        verifyCandidates(mask, i, haystack, needle, matches);
     }
-    return OTHER;
+    scanScalar(haystack, needle, i, matches);
+    return matches.count;
+}
+#endif
+
+// Pick the widest kernel the running CPU supports, once
+SearchKernel activeSearchKernel() {
+    static const SearchKernel kernel = []() -> SearchKernel {
+#ifdef FM_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return searchAvx2;
+        return searchSse2;
+#else
+        return searchScalar;
+#endif
+    }();
+    return kernel;
 }
 
 // Convert FileType enum to string for display
@@ -68,27 +898,44 @@ string fileTypeToString(FileType type) {
         default:       return "Other";
     }
 }
+// Catalog entry. Holds metadata only; content is fetched on demand through
+// FileList's content cache.
 struct FileNode {
-    string filename;
-    string content;
+    string_view filename; // Owned by FileList's name arena, NUL-terminated
     size_t size;
     time_t createdDate;
     time_t lastModified;
     time_t lastSeenDate;
     FileType type;
+    size_t id; // Creation sequence number, breaks ties in the ordered indexes
+    long lineCount; // -1 until the content has been loaded once
     FileNode* prev;
     FileNode* next;
+    // Links in FileList's position index (an implicit treap over list order)
+    FileNode* treeLeft;
+    FileNode* treeRight;
+    FileNode* treeParent;
+    uint32_t treePriority;
+    int treeSize; // Nodes in this subtree
   
-    FileNode(const string& name, const string& cont = "") : 
-        filename(name), content(cont), prev(nullptr), next(nullptr) {
+    FileNode(string_view name) : 
+        filename(name), id(0), lineCount(-1), prev(nullptr), next(nullptr),
+        treeLeft(nullptr), treeRight(nullptr), treeParent(nullptr), treePriority(0), treeSize(1) {
         type = getFileType(filename);
-        updateFileStats();
+        updateFileStats(fileSizeOnDisk(filename));
         createdDate = time(nullptr);
         lastSeenDate = time(nullptr);
     }
+
+    // Entry restored from stored metadata; no filesystem access
+    FileNode(string_view name, FileType fileType, size_t fileSize, time_t created, time_t modified) :
+        filename(name), size(fileType == DIRECTORY ? 0 : fileSize), createdDate(created),
+        lastModified(modified), lastSeenDate(time(nullptr)), type(fileType), id(0),
+        lineCount(-1), prev(nullptr), next(nullptr),
+        treeLeft(nullptr), treeRight(nullptr), treeParent(nullptr), treePriority(0), treeSize(1) {}
     
-    void updateFileStats() {
-        size = (type == DIRECTORY) ? 0 : content.size();
+    void updateFileStats(size_t newSize) {
+        size = (type == DIRECTORY) ? 0 : newSize;
         lastModified = time(nullptr);
         lastSeenDate = time(nullptr);
     }
@@ -101,175 +948,959 @@ struct FileNode {
         cout << "Modified: " << formatTime(lastModified) << "\n";
         cout << "Last Seen: " << formatTime(lastSeenDate) << "\n";
         
-        if (type != DIRECTORY) {
-            int lineCount = count(content.begin(), content.end(), '\n');
-            if (!content.empty() && content.back() != '\n') lineCount++;
+        if (type != DIRECTORY && lineCount >= 0) {
             cout << "Lines: " << lineCount << "\n";
         }
     }
 };
 
-// Structure for Recycle Bin items
-struct RecycleBinItem {
-    string originalPath;
-    string backupPath;
-    time_t deletionTime;
+// Catalog entry metadata as stored on disk, before it becomes a FileNode
+struct CatalogRecord {
+    string filename;
     FileType type;
-    
-    void displayInfo() const {
-        cout << "Original: " << originalPath << "\n";
-        cout << "Backup: " << backupPath << "\n";
-        cout << "Type: " << fileTypeToString(type) << "\n";
-        cout << "Deleted: " << formatTime(deletionTime) << "\n";
-    }
+    size_t size;
+    time_t created;
+    time_t modified;
 };
 
-// Recycle Bin class
-struct RecycleBin {
-
-    deque<RecycleBinItem> items;
-    string binPath;
-    size_t maxSize; // Maximum number of items in recycle bin
-    size_t maxStorage; // Maximum storage in bytes
-
-public:
-    RecycleBin() : maxSize(100), maxStorage(100 * 1024 * 1024) { // 100 items or 100MB
-        binPath = "recycle_bin";
-        if (!fs::exists(binPath)) {
-            fs::create_directory(binPath);
-        }
+// Work-stealing thread pool. Each worker owns a deque: it pops its own tasks
+// from the back and steals from the front of other workers' deques when idle.
+// Tasks may submit further tasks; wait() returns once every task has finished
+// and lends the calling thread to the pool in the meantime.
+struct ThreadPool {
+    struct WorkQueue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<WorkQueue>> queues;
+    vector<thread> workers;
+    mutex stateLock;
+    condition_variable workAvailable;
+    condition_variable allDone;
+    atomic<size_t> queued;  // Submitted but not yet picked up
+    atomic<size_t> pending; // Submitted but not yet finished
+    atomic<size_t> nextQueue;
+    bool stopping;
+
+    static unsigned defaultThreadCount() {
+        unsigned cores = thread::hardware_concurrency();
+        return cores == 0 ? 1 : cores;
     }
 
-    bool isFull() const {
-        if (items.size() >= maxSize) return true;
-        
-        size_t totalSize = 0;
-        for (const auto& item : items) {
-            if (fs::exists(item.backupPath)) {
-                totalSize += (item.type == DIRECTORY) ? 
-                    calculateDirectorySize(item.backupPath) : 
-                    fs::file_size(item.backupPath);
-            }
+    explicit ThreadPool(unsigned threadCount = 0) :
+        queued(0), pending(0), nextQueue(0), stopping(false) {
+        if (threadCount == 0) threadCount = defaultThreadCount();
+        for (unsigned i = 0; i < threadCount; i++) {
+            queues.push_back(make_unique<WorkQueue>());
+        }
+        for (unsigned i = 0; i < threadCount; i++) {
+            workers.emplace_back([this, i] { workerLoop(i); });
         }
-        return totalSize >= maxStorage;
     }
 
-    size_t calculateDirectorySize(const string& path) const {
-        size_t totalSize = 0;
-        for (const auto& entry : fs::recursive_directory_iterator(path)) {
-            if (fs::is_regular_file(entry)) {
-                totalSize += fs::file_size(entry);
-            }
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(stateLock);
+            stopping = true;
         }
-        return totalSize;
+        workAvailable.notify_all();
+        for (thread& worker : workers) worker.join();
     }
 
-    bool addToBin(const string& filepath) {
-        if (!fs::exists(filepath)) {
-            cerr << "File/directory doesn't exist: " << filepath << endl;
-            return false;
-        }
+    size_t threadCount() const { return workers.size(); }
 
-        if (isFull()) {
-            cerr << "Recycle bin is full. Please empty it first." << endl;
-            return false;
+    void submit(function<void()> task) {
+        size_t target = (currentWorker().first == this) ? currentWorker().second
+                                                         : nextQueue++ % queues.size();
+        pending++;
+        {
+            lock_guard<mutex> guard(stateLock);
+            queued++;
         }
+        {
+            lock_guard<mutex> guard(queues[target]->lock);
+            queues[target]->tasks.push_back(move(task));
+        }
+        workAvailable.notify_one();
+    }
 
-        RecycleBinItem item;
-        item.originalPath = filepath;
-        item.deletionTime = time(nullptr);
-        item.type = getFileType(filepath);
+    void wait() {
+        while (pending > 0) {
+            function<void()> task;
+            if (takeTask(nextQueue % queues.size(), task)) {
+                runTask(task);
+                continue;
+            }
+            unique_lock<mutex> guard(stateLock);
+            allDone.wait_for(guard, chrono::milliseconds(10), [this] { return pending == 0 || queued > 0; });
+        }
+    }
 
-        // Create unique backup filename
-        string filename = fs::path(filepath).filename().string();
-        string backupName = to_string(item.deletionTime) + "_" + filename;
-        item.backupPath = binPath + "/" + backupName;
+private:
+    // Which pool and queue the calling thread works for, if any
+    static pair<ThreadPool*, size_t>& currentWorker() {
+        static thread_local pair<ThreadPool*, size_t> worker(nullptr, 0);
+        return worker;
+    }
 
-        try {
-            if (item.type == DIRECTORY) {
-                fs::rename(filepath, item.backupPath);
+    bool takeTask(size_t home, function<void()>& task) {
+        for (size_t i = 0; i < queues.size(); i++) {
+            WorkQueue& queue = *queues[(home + i) % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            if (queue.tasks.empty()) continue;
+            if (i == 0) {
+                task = move(queue.tasks.back());
+                queue.tasks.pop_back();
             } else {
-                fs::copy(filepath, item.backupPath);
-                fs::remove(filepath);
+                task = move(queue.tasks.front());
+                queue.tasks.pop_front();
             }
-            items.push_back(item);
+            queued--;
             return true;
-        } catch (const exception& e) {
-            cerr << "Error moving to recycle bin: " << e.what() << endl;
-            return false;
         }
+        return false;
     }
 
-    void listItems() const {
-        if (items.empty()) {
-            cout << "Recycle Bin is empty.\n";
-            return;
+    void runTask(function<void()>& task) {
+        try {
+            task();
+        } catch (const exception& e) {
+            cerr << "Background task failed: " << e.what() << endl;
         }
-
-        cout << "\nRecycle Bin Contents (" << items.size() << " items):\n";
-        for (size_t i = 0; i < items.size(); i++) {
-            cout << i+1 << ". " << items[i].originalPath << "\n";
-            cout << "   Type: " << fileTypeToString(items[i].type) << "\n";
-            cout << "   Deleted: " << formatTime(items[i].deletionTime) << "\n";
+        if (--pending == 0) {
+            lock_guard<mutex> guard(stateLock);
+            allDone.notify_all();
         }
     }
 
-    bool restoreItem(size_t index) {
-        if (index >= items.size()) {
-            cout << "Invalid index.\n";
-            return false;
+    void workerLoop(size_t index) {
+        currentWorker() = make_pair(this, index);
+        while (true) {
+            function<void()> task;
+            if (takeTask(index, task)) {
+                runTask(task);
+                continue;
+            }
+            unique_lock<mutex> guard(stateLock);
+            workAvailable.wait(guard, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0) return;
         }
+    }
+};
 
-        RecycleBinItem item = items[index];
-        try {
-            if (fs::exists(item.originalPath)) {
-                cout << "Original location already exists. Cannot restore.\n";
-                return false;
-            }
+// Collects output and hands it to the stream in large writes instead of one
+// small write per line
+struct OutputBuffer {
+    static constexpr size_t FLUSH_BYTES = 1 << 20;
 
-            if (item.type == DIRECTORY) {
-                fs::rename(item.backupPath, item.originalPath);
-            } else {
-                fs::copy(item.backupPath, item.originalPath);
-                fs::remove(item.backupPath);
-            }
-            items.erase(items.begin() + index);
-            cout << "Restored: " << item.originalPath << "\n";
-            return true;
-        } catch (const exception& e) {
-            cerr << "Error restoring: " << e.what() << endl;
-            return false;
-        }
+    ostream& out;
+    string buffer;
+
+    explicit OutputBuffer(ostream& stream) : out(stream) {
+        buffer.reserve(FLUSH_BYTES + 4096);
     }
 
-    bool deleteItem(size_t index, bool permanent = false) {
-        if (index >= items.size()) {
-            cout << "Invalid index.\n";
-            return false;
-        }
+    ~OutputBuffer() {
+        flush();
+    }
 
-        RecycleBinItem item = items[index];
-        try {
-            if (permanent) {
-                if (item.type == DIRECTORY) {
-                    fs::remove_all(item.backupPath);
-                } else {
-                    fs::remove(item.backupPath);
+    void append(string_view text) {
+        buffer.append(text.data(), text.size());
+        if (buffer.size() >= FLUSH_BYTES) writePending();
+    }
+
+    void append(char c) {
+        buffer.push_back(c);
+    }
+
+    void appendNumber(uint64_t value) {
+        char digits[20];
+        to_chars_result result = to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr - digits);
+    }
+
+    void flush() {
+        writePending();
+        out.flush();
+    }
+
+private:
+    void writePending() {
+        if (buffer.empty()) return;
+        out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        buffer.clear();
+    }
+};
+
+#ifdef __linux__
+// Directory entries straight from getdents64, a large buffer at a time. The
+// d_type of each entry is passed through; DT_UNKNOWN means the caller has to
+// stat to learn the type.
+struct DirentReader {
+    // Record layout returned by getdents64
+    struct LinuxDirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    int fd;
+    vector<char> buffer;
+    size_t offset;
+    size_t length;
+
+    explicit DirentReader(size_t bufferBytes = 1 << 20) : fd(-1), buffer(bufferBytes), offset(0), length(0) {}
+    DirentReader(const DirentReader&) = delete;
+    DirentReader& operator=(const DirentReader&) = delete;
+
+    ~DirentReader() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool open(const string& path) {
+        fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        return fd >= 0;
+    }
+
+    // Next entry other than "." and "..". The name is NUL-terminated and valid
+    // until the next call. Returns false at the end (errno 0) or on error.
+    bool next(string_view& name, unsigned char& type) {
+        while (true) {
+            if (offset >= length) {
+                long n = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    if (n == 0) errno = 0;
+                    return false;
                 }
-                cout << "Permanently deleted: " << item.originalPath << "\n";
-            } else {
-                cout << "Deleted: " << item.originalPath << "\n";
+                offset = 0;
+                length = static_cast<size_t>(n);
             }
-            items.erase(items.begin() + index);
+
+            const LinuxDirent64* record = reinterpret_cast<const LinuxDirent64*>(buffer.data() + offset);
+            offset += record->d_reclen;
+            name = record->d_name;
+            if (name == "." || name == "..") continue;
+            type = record->d_type;
             return true;
-        } catch (const exception& e) {
-            cerr << "Error deleting: " << e.what() << endl;
+        }
+    }
+};
+#endif
+
+string formatBytes(uint64_t bytes) {
+    const char* units[] = {"bytes", "KB", "MB", "GB", "TB"};
+    double value = static_cast<double>(bytes);
+    size_t unit = 0;
+    while (value >= 1024.0 && unit + 1 < sizeof(units) / sizeof(units[0])) {
+        value /= 1024.0;
+        unit++;
+    }
+    ostringstream out;
+    if (unit == 0) {
+        out << bytes << " bytes";
+    } else {
+        out << fixed << setprecision(1) << value << " " << units[unit];
+    }
+    return out.str();
+}
+
+// Sizes and counts for a directory's own entries or its whole subtree
+struct DirectoryTotals {
+    uint64_t bytes; // Regular file sizes
+    uint64_t files; // Everything that is not a directory
+    uint64_t directories; // Below this one, not counting itself
+    uint64_t bytesByType[OTHER + 1];
+    uint64_t filesByType[OTHER + 1];
+
+    DirectoryTotals() : bytes(0), files(0), directories(0), bytesByType(), filesByType() {}
+
+    void addFile(FileType type, uint64_t size) {
+        bytes += size;
+        files++;
+        bytesByType[type] += size;
+        filesByType[type]++;
+    }
+
+    void add(const DirectoryTotals& other) {
+        bytes += other.bytes;
+        files += other.files;
+        directories += other.directories;
+        for (int type = 0; type <= OTHER; type++) {
+            bytesByType[type] += other.bytesByType[type];
+            filesByType[type] += other.filesByType[type];
+        }
+    }
+};
+
+// Recursive walk that aggregates sizes per directory. Every directory is a
+// task on a work-stealing ThreadPool: the worker lists it with getdents64,
+// stats only regular files (for their size) and entries whose d_type is
+// unknown, using statx relative to the open directory, and pushes the
+// subdirectories it finds onto its own deque, where idle workers steal them.
+// A deep tree therefore keeps every worker issuing I/O. Without a pool the
+// walk runs on the calling thread. Symlinks are counted, never followed.
+//
+// A directory is always registered after its parent, so once the walk is
+// done the cumulative totals are summed in one pass from the last index down.
+//
+// With a collect callback every entry is stat'ed, and each scanned
+// directory hands over one batch of catalog records for its entries.
+struct TreeWalker {
+    static constexpr size_t NO_PARENT = numeric_limits<size_t>::max();
+    static constexpr size_t READ_BUFFER_BYTES = 64 * 1024;
+
+    struct Directory {
+        string path;
+        size_t parent;
+        int depth;
+        DirectoryTotals own;   // Entries directly inside
+        DirectoryTotals total; // The whole subtree
+        vector<size_t> children; // Filled in after the walk
+    };
+
+    ThreadPool* pool;
+    deque<Directory> directories; // Index 0 is the root; elements never move
+    unordered_map<string_view, size_t> pathIndex; // Views of directories' paths; filled in after the walk
+    mutex directoriesLock;
+    vector<size_t> pendingScans; // Used when there is no pool
+    atomic<size_t> unreadable; // Directories that could not be listed
+    atomic<size_t> entriesSeen; // Progress while a walk runs
+    double elapsedMs;
+    // Called once per directory with records for its entries, subdirectories
+    // included; may run on several threads at once
+    function<void(vector<CatalogRecord>&)> collect;
+
+    explicit TreeWalker(ThreadPool* threadPool = nullptr) :
+        pool(threadPool), unreadable(0), entriesSeen(0), elapsedMs(0) {}
+
+    // Walk everything under root. A root that is not a directory is measured
+    // as a single entry. Returns false if root does not exist.
+    bool walk(const string& root) {
+        auto start = chrono::steady_clock::now();
+        directories.clear();
+        pathIndex.clear();
+        unreadable = 0;
+        entriesSeen = 0;
+
+        error_code ec;
+        fs::file_status status = fs::symlink_status(root, ec);
+        if (ec || !fs::exists(status)) return false;
+
+        directories.push_back(Directory{root, NO_PARENT, 0, {}, {}, {}});
+        if (!fs::is_directory(status)) {
+            uintmax_t size = fs::is_regular_file(status) ? fs::file_size(root, ec) : 0;
+            directories[0].own.addFile(getFileTypeFromExtension(root), ec ? 0 : size);
+        } else if (pool) {
+            Directory* rootDirectory = &directories[0];
+            pool->submit([this, rootDirectory] { scan(rootDirectory, 0); });
+            pool->wait();
+        } else {
+            pendingScans.push_back(0);
+            while (!pendingScans.empty()) {
+                size_t index = pendingScans.back();
+                pendingScans.pop_back();
+                scan(&directories[index], index);
+            }
+        }
+
+        aggregate();
+        elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    const DirectoryTotals& totals() const {
+        return directories.front().total;
+    }
+
+    // Index of the directory with this path, or NO_PARENT
+    size_t find(string_view path) const {
+        auto it = pathIndex.find(path);
+        return it == pathIndex.end() ? NO_PARENT : it->second;
+    }
+
+    // Directories only, largest subtree first. maxDepth 0 means no limit.
+    void printTree(OutputBuffer& out, int maxDepth) const {
+        if (directories.empty()) return;
+        // (index, prefix for its children, is last sibling)
+        vector<tuple<size_t, string, bool>> stack;
+        stack.emplace_back(0, "", true);
+        while (!stack.empty()) {
+            size_t index;
+            string prefix;
+            bool last;
+            tie(index, prefix, last) = stack.back();
+            stack.pop_back();
+
+            const Directory& directory = directories[index];
+            if (index == 0) {
+                out.append(directory.path);
+            } else {
+                out.append(prefix);
+                out.append(last ? "`-- " : "|-- ");
+                out.append(fs::path(directory.path).filename().string());
+                prefix += last ? "    " : "|   ";
+            }
+            out.append("/ (");
+            out.append(formatBytes(directory.total.bytes));
+            out.append(", ");
+            out.appendNumber(directory.total.files);
+            out.append(" files)\n");
+
+            if (maxDepth != 0 && directory.depth >= maxDepth) continue;
+            vector<size_t> children = directory.children;
+            sort(children.begin(), children.end(), [this](size_t a, size_t b) {
+                return directories[a].total.bytes > directories[b].total.bytes;
+            });
+            // Pushed in reverse so the largest is printed first
+            for (size_t i = children.size(); i-- > 0;) {
+                stack.emplace_back(children[i], prefix, i + 1 == children.size());
+            }
+        }
+    }
+
+private:
+    size_t addDirectory(string path, size_t parent, int depth, Directory*& added) {
+        lock_guard<mutex> guard(directoriesLock);
+        directories.push_back(Directory{move(path), parent, depth, {}, {}, {}});
+        added = &directories.back();
+        return directories.size() - 1;
+    }
+
+    void schedule(Directory* directory, size_t index) {
+        if (pool) {
+            pool->submit([this, directory, index] { scan(directory, index); });
+        } else {
+            pendingScans.push_back(index);
+        }
+    }
+
+    static string joinPath(const string& parent, string_view name) {
+        string path = parent;
+        if (!path.empty() && path.back() != '/') path.push_back('/');
+        path.append(name.data(), name.size());
+        return path;
+    }
+
+    void addSubdirectory(Directory* directory, size_t index, string path) {
+        directory->own.directories++;
+        Directory* child;
+        size_t childIndex = addDirectory(move(path), index, directory->depth + 1, child);
+        schedule(child, childIndex);
+    }
+
+    // Account for one entry of a directory being scanned
+    void addEntry(Directory* directory, size_t index, string_view name, bool isDirectory, uint64_t size,
+                  time_t created, time_t modified, vector<CatalogRecord>& records) {
+        FileType type = isDirectory ? DIRECTORY : getFileTypeFromExtension(name);
+        if (collect) {
+            records.push_back({joinPath(directory->path, name), type, size, created, modified});
+        }
+        if (isDirectory) {
+            addSubdirectory(directory, index, collect ? records.back().filename : joinPath(directory->path, name));
+        } else {
+            directory->own.addFile(type, size);
+        }
+    }
+
+    void finishScan(size_t seen, vector<CatalogRecord>& records) {
+        entriesSeen += seen;
+        if (collect && !records.empty()) collect(records);
+    }
+
+#ifdef __linux__
+    void scan(Directory* directory, size_t index) {
+        DirentReader reader(READ_BUFFER_BYTES);
+        if (!reader.open(directory->path)) {
+            unreadable++;
+            return;
+        }
+
+        unsigned mask = collect ? (STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_BTIME) : (STATX_TYPE | STATX_SIZE);
+        vector<CatalogRecord> records;
+        size_t seen = 0;
+        string_view name;
+        unsigned char type;
+        while (reader.next(name, type)) {
+            seen++;
+            struct statx info;
+            bool statted = (collect || type == DT_REG || type == DT_UNKNOWN) &&
+                           statx(reader.fd, name.data(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, &info) == 0;
+            bool isDirectory = statted ? S_ISDIR(info.stx_mode) : type == DT_DIR;
+            uint64_t size = (statted && S_ISREG(info.stx_mode)) ? info.stx_size : 0;
+            time_t modified = statted ? static_cast<time_t>(info.stx_mtime.tv_sec) : 0;
+            time_t created = (statted && (info.stx_mask & STATX_BTIME)) ? static_cast<time_t>(info.stx_btime.tv_sec)
+                                                                         : modified;
+            addEntry(directory, index, name, isDirectory, size, created, modified, records);
+        }
+        if (errno != 0) unreadable++;
+        finishScan(seen, records);
+    }
+#else
+    void scan(Directory* directory, size_t index) {
+        error_code ec;
+        fs::directory_iterator it(directory->path, ec);
+        if (ec) {
+            unreadable++;
+            return;
+        }
+        vector<CatalogRecord> records;
+        size_t seen = 0;
+        for (fs::directory_iterator end; it != end; it.increment(ec)) {
+            seen++;
+            fs::file_status status = it->symlink_status(ec);
+            uintmax_t size = fs::is_regular_file(status) ? it->file_size(ec) : 0;
+            if (ec) size = 0;
+            time_t modified = 0;
+            if (collect) {
+                auto stamp = it->last_write_time(ec);
+                if (!ec) {
+                    modified = chrono::system_clock::to_time_t(
+                        chrono::time_point_cast<chrono::system_clock::duration>(
+                            stamp - decltype(stamp)::clock::now() + chrono::system_clock::now()));
+                }
+            }
+            addEntry(directory, index, it->path().filename().string(), fs::is_directory(status), size,
+                     modified, modified, records);
+        }
+        finishScan(seen, records);
+    }
+#endif
+
+    void aggregate() {
+        pathIndex.reserve(directories.size());
+        for (size_t i = 0; i < directories.size(); i++) {
+            Directory& directory = directories[i];
+            directory.total = directory.own;
+            directory.children.clear();
+            pathIndex.emplace(directory.path, i);
+        }
+        for (size_t i = directories.size(); i-- > 1;) {
+            Directory& parent = directories[directories[i].parent];
+            parent.total.add(directories[i].total);
+            parent.children.push_back(i);
+        }
+    }
+};
+
+// Structure for Recycle Bin items
+struct RecycleBinItem {
+    uint64_t id; // Insertion sequence number, also the listing order
+    string originalPath;
+    string backupPath;
+    time_t deletionTime;
+    FileType type;
+    size_t bytes; // Size on disk when last measured
+    
+    void displayInfo() const {
+        cout << "Original: " << originalPath << "\n";
+        cout << "Backup: " << backupPath << "\n";
+        cout << "Type: " << fileTypeToString(type) << "\n";
+        cout << "Deleted: " << formatTime(deletionTime) << "\n";
+    }
+};
+
+// Recycle Bin class. Usage is tracked as a running byte total that is updated
+// on every add, restore and delete, so isFull() is O(1). An optional
+// background reconciler rescans the bin now and then to pick up changes made
+// outside the program.
+//
+// Entries are persisted in a manifest inside the bin directory: an
+// append-only log of framed add/remove records, compacted once dead records
+// outnumber live ones. On startup the manifest is loaded and checked against
+// a single scan of the bin directory; backups the manifest does not know
+// about are adopted and entries whose backup is gone are dropped.
+//
+// When the bin is full, an eviction policy can make room instead of refusing
+// the delete. Evicted backups are renamed into a purge directory and removed
+// by a background thread, so a delete never waits on remove_all of a large
+// tree. The same thread expires items older than the retention period.
+struct RecycleBin {
+    static constexpr const char* MANIFEST_NAME = ".manifest";
+    static constexpr const char* PURGE_DIR_NAME = ".purge";
+    static constexpr const char* MANIFEST_MAGIC = "FMBIN1";
+    static constexpr size_t MIN_COMPACTION_RECORDS = 1024;
+    static constexpr size_t BATCH_CHUNK_SIZE = 64; // Entries per pool task in batch moves
+
+    enum ManifestOp : char { OP_ADD = 'A', OP_REMOVE = 'R' };
+
+    enum EvictionPolicy {
+        EVICT_NONE,             // Refuse new items when full
+        EVICT_OLDEST,           // Purge the oldest items first
+        EVICT_LARGEST_PAST_AGE  // Purge the largest items older than evictionMinAge, then the oldest
+    };
+
+    struct PurgeJob {
+        string path;
+        size_t bytes;
+    };
+
+    typedef map<uint64_t, RecycleBinItem>::iterator ItemIterator;
+
+    map<uint64_t, RecycleBinItem> items;
+    multimap<string, uint64_t> byOriginalPath;
+    set<pair<time_t, uint64_t>> byDeletionTime;
+    unordered_map<string, uint64_t> byBackupName;
+    uint64_t nextItemId;
+    string binPath;
+    string manifestPath;
+    size_t manifestRecords; // Records in the manifest, live or not
+    size_t maxSize; // Maximum number of items in recycle bin
+    size_t maxStorage; // Maximum storage in bytes
+    size_t totalBytes; // Sum of item sizes
+    mutable mutex lock; // Guards items and totalBytes against the reconciler
+
+    EvictionPolicy evictionPolicy;
+    time_t evictionMinAge; // Seconds, for EVICT_LARGEST_PAST_AGE
+    time_t retention; // Seconds an item is kept before it expires; 0 keeps it forever
+    size_t evictedItems;
+    atomic<size_t> purgedItems;
+    atomic<size_t> reclaimedBytes;
+    string purgePath;
+    thread purger;
+    mutex purgeLock;
+    condition_variable purgeWake;
+    deque<PurgeJob> purgeQueue;
+    bool purgerStopping;
+
+    unique_ptr<ThreadPool> batchPool; // Created on the first batch worth splitting
+
+    thread reconciler;
+    mutex reconcilerLock;
+    condition_variable reconcilerWake;
+    chrono::seconds reconcileInterval;
+    bool reconcilerStopping;
+    size_t reconcilePasses;
+    size_t reconcileDrift; // Bytes of difference found on the last pass
+
+public:
+    RecycleBin() : nextItemId(1), manifestRecords(0), maxSize(100), maxStorage(100 * 1024 * 1024), // 100 items or 100MB
+                   totalBytes(0), evictionPolicy(EVICT_NONE), evictionMinAge(0), retention(0), evictedItems(0),
+                   purgedItems(0), reclaimedBytes(0), purgerStopping(false), reconcileInterval(60),
+                   reconcilerStopping(false), reconcilePasses(0), reconcileDrift(0) {
+        binPath = "recycle_bin";
+        manifestPath = binPath + "/" + MANIFEST_NAME;
+        purgePath = binPath + "/" + PURGE_DIR_NAME;
+        if (!fs::exists(binPath)) {
+            fs::create_directory(binPath);
+        }
+        loadManifest();
+
+        // Finish purges interrupted by the last exit
+        error_code ec;
+        for (fs::directory_iterator it(purgePath, ec), end; !ec && it != end; it.increment(ec)) {
+            lock_guard<mutex> guard(purgeLock);
+            purgeQueue.push_back({it->path().string(), 0});
+        }
+        if (!purgeQueue.empty()) startPurger();
+    }
+
+    ~RecycleBin() {
+        stopPurger();
+        stopReconciler();
+    }
+
+    void setEvictionPolicy(EvictionPolicy policy, time_t minAge, time_t retentionPeriod) {
+        {
+            lock_guard<mutex> guard(lock);
+            evictionPolicy = policy;
+            evictionMinAge = minAge;
+            retention = retentionPeriod;
+        }
+        if (retentionPeriod > 0) {
+            startPurger();
+            purgeWake.notify_all();
+        }
+    }
+
+    void displayEvictionStats() const {
+        lock_guard<mutex> guard(lock);
+        static const char* policyNames[] = {"refuse when full", "oldest first", "largest past age"};
+        cout << "Eviction policy: " << policyNames[evictionPolicy];
+        if (evictionPolicy == EVICT_LARGEST_PAST_AGE) {
+            cout << " (" << evictionMinAge / 3600 << " h)";
+        }
+        cout << ", retention: ";
+        if (retention > 0) {
+            cout << retention / 86400 << " days\n";
+        } else {
+            cout << "unlimited\n";
+        }
+        cout << "Evicted: " << evictedItems << " items, purged: " << purgedItems.load()
+             << ", reclaimed: " << fixed << setprecision(2) << (reclaimedBytes.load() / (1024.0 * 1024.0))
+             << " MB\n";
+    }
+
+    bool isFull() const {
+        lock_guard<mutex> guard(lock);
+        return items.size() >= maxSize || totalBytes >= maxStorage;
+    }
+
+    size_t usedBytes() const {
+        lock_guard<mutex> guard(lock);
+        return totalBytes;
+    }
+
+    // Walks on the pool if given; callers already running on a pool pass none
+    size_t calculateDirectorySize(const string& path, ThreadPool* pool = nullptr) const {
+        TreeWalker walker(pool);
+        return walker.walk(path) ? walker.totals().bytes : 0;
+    }
+
+    // Bytes used by a bin entry, or 0 if it is gone
+    size_t measure(const string& path, FileType type, ThreadPool* pool = nullptr) const {
+        error_code ec;
+        if (type == DIRECTORY) {
+            return fs::is_directory(path, ec) ? calculateDirectorySize(path, pool) : 0;
+        }
+        uintmax_t fileSize = fs::file_size(path, ec);
+        return ec ? 0 : fileSize;
+    }
+
+    bool addToBin(const string& filepath) {
+        return addToBin(vector<string>{filepath}) == 1;
+    }
+
+    // Move a batch of files/directories into the bin; the manifest gets one
+    // write per chunk. Large batches are measured and moved on the bin's
+    // thread pool. With an eviction policy, a batch larger than the bin goes
+    // in chunks that each fit on their own: a chunk is moved and committed
+    // first, and only then are older items evicted to bring the bin back
+    // within its limits, so a failed move never costs an item. Without one,
+    // a batch that does not fit is refused before anything moves.
+    // Returns how many entries were moved; `moved`, if given, receives their
+    // paths in input order.
+    size_t addToBin(const vector<string>& filepaths, vector<string>* moved = nullptr) {
+        struct Source {
+            bool exists;
+            FileType type;
+            size_t bytes;
+        };
+
+        time_t now = time(nullptr);
+        ThreadPool* pool = nullptr;
+        if (filepaths.size() > BATCH_CHUNK_SIZE) {
+            if (!batchPool) batchPool = make_unique<ThreadPool>();
+            pool = batchPool.get();
+        }
+
+        vector<Source> sources(filepaths.size());
+        runChunked(pool, filepaths.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                error_code ec;
+                fs::file_status status = fs::status(filepaths[i], ec);
+                sources[i].exists = fs::exists(status);
+                sources[i].type = getFileType(filepaths[i], status);
+                sources[i].bytes = sources[i].exists ? measure(filepaths[i], sources[i].type) : 0;
+            }
+        });
+
+        vector<size_t> accepted;
+        accepted.reserve(filepaths.size());
+        for (size_t i = 0; i < filepaths.size(); i++) {
+            if (sources[i].exists) {
+                accepted.push_back(i);
+            } else {
+                cerr << "File/directory doesn't exist: " << filepaths[i] << endl;
+            }
+        }
+
+        // An item is taken while the bin is not yet full, as for single adds
+        auto fullAt = [this](size_t count, size_t bytes) {
+            return count >= maxSize || bytes >= maxStorage;
+        };
+
+        vector<pair<size_t, size_t>> chunks; // [begin, end) into accepted
+        {
+            lock_guard<mutex> guard(lock);
+            size_t count = evictionPolicy == EVICT_NONE ? items.size() : 0;
+            size_t bytes = evictionPolicy == EVICT_NONE ? totalBytes : 0;
+            size_t chunkBegin = 0;
+            for (size_t k = 0; k < accepted.size(); k++) {
+                if (fullAt(count, bytes)) {
+                    if (evictionPolicy == EVICT_NONE) {
+                        cerr << "Recycle bin is full: room for " << k << " of " << accepted.size()
+                             << " item(s). Empty it or enable eviction first." << endl;
+                        return 0;
+                    }
+                    chunks.emplace_back(chunkBegin, k);
+                    chunkBegin = k;
+                    count = bytes = 0;
+                }
+                count++;
+                bytes += sources[accepted[k]].bytes;
+            }
+            if (chunkBegin < accepted.size()) chunks.emplace_back(chunkBegin, accepted.size());
+        }
+
+        size_t movedCount = 0;
+        for (const auto& chunk : chunks) {
+            vector<RecycleBinItem> batch;
+            batch.reserve(chunk.second - chunk.first);
+            {
+                lock_guard<mutex> guard(lock);
+                for (size_t k = chunk.first; k < chunk.second; k++) {
+                    size_t i = accepted[k];
+                    RecycleBinItem item;
+                    item.id = nextItemId++;
+                    item.originalPath = filepaths[i];
+                    item.deletionTime = now;
+                    item.type = sources[i].type;
+                    item.bytes = sources[i].bytes;
+                    item.backupPath = binPath + "/" + backupNameFor(item);
+                    batch.push_back(move(item));
+                }
+            }
+            movedCount += moveBatch(batch, pool, now, moved);
+        }
+        return movedCount;
+    }
+
+    // Start rescanning the bin every `interval`; a no-op if already running
+    void startReconciler(chrono::seconds interval) {
+        if (reconciler.joinable()) return;
+        reconcileInterval = interval;
+        reconcilerStopping = false;
+        reconciler = thread([this] { reconcileLoop(); });
+    }
+
+    void stopReconciler() {
+        if (!reconciler.joinable()) return;
+        {
+            lock_guard<mutex> guard(reconcilerLock);
+            reconcilerStopping = true;
+        }
+        reconcilerWake.notify_all();
+        reconciler.join();
+    }
+
+    bool reconcilerRunning() const {
+        return reconciler.joinable();
+    }
+
+    // Re-measure every item and correct the running total. Sizes are taken
+    // without holding the lock so adds and restores are not blocked; items
+    // added or removed meanwhile keep their own accounting. Directories are
+    // walked serially on the calling thread: this is a low-rate background
+    // check and should not wake a worker per core on every pass.
+    void reconcile() {
+        vector<tuple<uint64_t, string, FileType>> snapshot;
+        {
+            lock_guard<mutex> guard(lock);
+            snapshot.reserve(items.size());
+            for (const auto& entry : items) {
+                snapshot.emplace_back(entry.first, entry.second.backupPath, entry.second.type);
+            }
+        }
+
+        vector<pair<uint64_t, size_t>> measured;
+        measured.reserve(snapshot.size());
+        for (const auto& entry : snapshot) {
+            measured.emplace_back(get<0>(entry), measure(get<1>(entry), get<2>(entry)));
+        }
+
+        lock_guard<mutex> guard(lock);
+        size_t previous = totalBytes;
+        for (const auto& entry : measured) {
+            auto it = items.find(entry.first);
+            if (it != items.end()) it->second.bytes = entry.second;
+        }
+        totalBytes = 0;
+        for (const auto& entry : items) {
+            totalBytes += entry.second.bytes;
+        }
+        reconcileDrift = previous > totalBytes ? previous - totalBytes : totalBytes - previous;
+        reconcilePasses++;
+    }
+
+    void reconcileLoop() {
+        unique_lock<mutex> guard(reconcilerLock);
+        while (!reconcilerWake.wait_for(guard, reconcileInterval, [this] { return reconcilerStopping; })) {
+            guard.unlock();
+            reconcile();
+            guard.lock();
+        }
+    }
+
+    void listItems() const {
+        lock_guard<mutex> guard(lock);
+        if (items.empty()) {
+            cout << "Recycle Bin is empty.\n";
+            return;
+        }
+
+        // Items are numbered by id, so the number typed back is one lookup
+        cout << "\nRecycle Bin Contents (" << items.size() << " items):\n";
+        for (const auto& entry : items) {
+            printItem(entry.first, entry.second);
+        }
+    }
+
+    // Items deleted at or after `since`, oldest first
+    void listItemsDeletedSince(time_t since) const {
+        lock_guard<mutex> guard(lock);
+        size_t shown = 0;
+        for (auto it = byDeletionTime.lower_bound({since, 0}); it != byDeletionTime.end(); ++it) {
+            const RecycleBinItem& item = items.at(it->second);
+            cout << "- " << item.originalPath << "\n";
+            cout << "   Type: " << fileTypeToString(item.type) << "\n";
+            cout << "   Deleted: " << formatTime(item.deletionTime) << "\n";
+            shown++;
+        }
+        if (shown == 0) {
+            cout << "No items deleted in that period.\n";
+        }
+    }
+
+    // By the number listItems shows, which is the item's id
+    bool restoreItem(uint64_t id) {
+        lock_guard<mutex> guard(lock);
+        ItemIterator it = items.find(id);
+        if (it == items.end()) {
+            cout << "No recycle bin item number " << id << ".\n";
+            return false;
+        }
+        return restoreEntry(it);
+    }
+
+    // Restore the most recently deleted item that came from `originalPath`
+    bool restoreItem(const string& originalPath) {
+        lock_guard<mutex> guard(lock);
+        ItemIterator it = findByOriginalPath(originalPath);
+        if (it == items.end()) {
+            cout << "No recycle bin item for " << originalPath << ".\n";
+            return false;
+        }
+        return restoreEntry(it);
+    }
+
+    bool deleteItem(uint64_t id, bool permanent = false) {
+        lock_guard<mutex> guard(lock);
+        ItemIterator it = items.find(id);
+        if (it == items.end()) {
+            cout << "No recycle bin item number " << id << ".\n";
+            return false;
+        }
+        return deleteEntry(it, permanent);
+    }
+
+    bool deleteItem(const string& originalPath, bool permanent = false) {
+        lock_guard<mutex> guard(lock);
+        ItemIterator it = findByOriginalPath(originalPath);
+        if (it == items.end()) {
+            cout << "No recycle bin item for " << originalPath << ".\n";
             return false;
         }
+        return deleteEntry(it, permanent);
     }
 
     void emptyBin() {
-        for (auto& item : items) {
+        lock_guard<mutex> guard(lock);
+        for (auto& entry : items) {
+            const RecycleBinItem& item = entry.second;
             try {
                 if (item.type == DIRECTORY) {
                     fs::remove_all(item.backupPath);
@@ -281,404 +1912,3061 @@ public:
             }
         }
         items.clear();
+        byOriginalPath.clear();
+        byDeletionTime.clear();
+        byBackupName.clear();
+        totalBytes = 0;
+        writeManifest();
         cout << "Recycle Bin emptied.\n";
     }
 
     size_t size() const {
+        lock_guard<mutex> guard(lock);
         return items.size();
     }
-};
 
-// Doubly linked list for file management
-struct FileList {
+private:
+    // Move one chunk into the bin, record what arrived, then evict older items
+    // while the bin is over its limits. Items of this chunk are never evicted.
+    size_t moveBatch(vector<RecycleBinItem>& batch, ThreadPool* pool, time_t now, vector<string>* moved) {
+        vector<string> errors(batch.size());
+        runChunked(pool, batch.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                try {
+                    // The id makes the name unique, but never clobber a stray file
+                    error_code ec;
+                    if (fs::exists(batch[i].backupPath, ec)) {
+                        throw fs::filesystem_error("backup exists", batch[i].backupPath,
+                                                   make_error_code(errc::file_exists));
+                    }
+                    moveEntry(batch[i].originalPath, batch[i].backupPath);
+                } catch (const exception& e) {
+                    errors[i] = e.what();
+                }
+            }
+        });
+
+        vector<string> records; // Additions first, then the evictions they caused
+        records.reserve(batch.size());
+        uint64_t firstId = batch.front().id;
+        lock_guard<mutex> guard(lock);
+        size_t done = 0;
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (!errors[i].empty()) {
+                cerr << "Error moving to recycle bin: " << errors[i] << endl;
+                continue;
+            }
+            string record;
+            encodeAdd(record, batch[i]);
+            records.push_back(move(record));
+            if (moved) moved->push_back(batch[i].originalPath);
+            insertItem(move(batch[i]));
+            done++;
+        }
+        if (done == 0) return 0;
 
-    FileNode* head;                                              
-    FileNode* tail;
-    int count;
-    
-    void swapNodesData(FileNode* a, FileNode* b) {
-        swap(a->filename, b->filename);
-        swap(a->content, b->content);
-        swap(a->size, b->size);
-        swap(a->type, b->type);
-        swap(a->createdDate, b->createdDate);
-        swap(a->lastModified, b->lastModified);
-        swap(a->lastSeenDate, b->lastSeenDate);
+        EvictionCandidates candidates;
+        candidates.newestId = firstId;
+        while ((items.size() > maxSize || totalBytes > maxStorage) && evictOne(candidates, now, records)) {
+        }
+        appendManifest(records);
+        return done;
     }
 
-
-    FileList() : head(nullptr), tail(nullptr), count(0) {}
-    
-    ~FileList() {
-        clear();
+    // Run work over [0, count) in BATCH_CHUNK_SIZE pieces, on the pool if given
+    static void runChunked(ThreadPool* pool, size_t count, const function<void(size_t, size_t)>& work) {
+        if (!pool) {
+            work(0, count);
+            return;
+        }
+        for (size_t begin = 0; begin < count; begin += BATCH_CHUNK_SIZE) {
+            pool->submit([&work, begin, count] { work(begin, min(count, begin + BATCH_CHUNK_SIZE)); });
+        }
+        pool->wait();
     }
 
-    bool isEmpty() const { return head == nullptr; }
-    int size() const { return count; }
+    // Victims for EVICT_LARGEST_PAST_AGE, collected once per batch. Items
+    // with ids from newestId on belong to the batch and are never victims.
+    struct EvictionCandidates {
+        vector<uint64_t> largest;
+        size_t next = 0;
+        bool collected = false;
+        uint64_t newestId = numeric_limits<uint64_t>::max();
+    };
+
+    // Evict one item under the current policy; caller holds lock. The removal
+    // record is added to `records` for the caller to write.
+    bool evictOne(EvictionCandidates& candidates, time_t now, vector<string>& records) {
+        if (evictionPolicy == EVICT_NONE || byDeletionTime.empty() ||
+            byDeletionTime.begin()->second >= candidates.newestId) {
+            return false;
+        }
 
-    bool contains(const string& filename) const {
-        FileNode* current = head;
-        while (current) {
-            if (current->filename == filename) return true;
-            current = current->next;
+        ItemIterator victim = items.end();
+        if (evictionPolicy == EVICT_LARGEST_PAST_AGE) {
+            if (!candidates.collected) {
+                for (const auto& entry : byDeletionTime) {
+                    if (entry.first > now - evictionMinAge) break;
+                    if (entry.second >= candidates.newestId) continue;
+                    candidates.largest.push_back(entry.second);
+                }
+                sort(candidates.largest.begin(), candidates.largest.end(), [this](uint64_t a, uint64_t b) {
+                    return items.at(a).bytes > items.at(b).bytes;
+                });
+                candidates.collected = true;
+            }
+            while (candidates.next < candidates.largest.size() && victim == items.end()) {
+                victim = items.find(candidates.largest[candidates.next++]);
+            }
         }
-        return false;
+        if (victim == items.end()) {
+            victim = items.find(byDeletionTime.begin()->second);
+        }
+        evictItem(victim, records);
+        return true;
     }
 
-    void addFileAtBeginning(const string& filename, const string& content) {
-        if (contains(filename)) {
-            cout << "File '" << filename << "' already exists.\n";
-            return;
+    // Forget an item and hand its backup to the purge thread
+    void evictItem(ItemIterator it, vector<string>& records) {
+        RecycleBinItem& item = it->second;
+        string target = item.backupPath;
+        error_code ec;
+        fs::create_directory(purgePath, ec);
+        fs::rename(item.backupPath, purgePath + "/" + fs::path(item.backupPath).filename().string(), ec);
+        if (!ec) target = purgePath + "/" + fs::path(item.backupPath).filename().string();
+
+        string record(1, OP_REMOVE);
+        writeVarint(record, item.id);
+        records.push_back(move(record));
+        evictedItems++;
+        {
+            lock_guard<mutex> guard(purgeLock);
+            purgeQueue.push_back({target, item.bytes});
         }
+        unindexItem(item);
+        items.erase(it);
+        startPurger();
+        purgeWake.notify_one();
+    }
 
-        FileNode* newNode = new FileNode(filename, content);
-        if (isEmpty()) {
-            head = tail = newNode;
-        } else {
-            newNode->next = head;
-            head->prev = newNode;
-            head = newNode;
+    void expireOldItems() {
+        lock_guard<mutex> guard(lock);
+        if (retention <= 0) return;
+        time_t cutoff = time(nullptr) - retention;
+        vector<string> records;
+        while (!byDeletionTime.empty() && byDeletionTime.begin()->first < cutoff) {
+            evictItem(items.find(byDeletionTime.begin()->second), records);
         }
-        count++;
+        if (!records.empty()) appendManifest(records);
     }
 
-    void addFileAtEnd(const string& filename, const string& content) {
-        if (contains(filename)) {
-            cout << "File '" << filename << "' already exists.\n";
-            return;
+    void startPurger() {
+        if (purger.joinable()) return;
+        purgerStopping = false;
+        purger = thread([this] { purgeLoop(); });
+    }
+
+    // Pending purges that are cut short here resume on the next start
+    void stopPurger() {
+        if (!purger.joinable()) return;
+        {
+            lock_guard<mutex> guard(purgeLock);
+            purgerStopping = true;
         }
+        purgeWake.notify_all();
+        purger.join();
+    }
 
-        FileNode* newNode = new FileNode(filename, content);
-        if (isEmpty()) {
-            head = tail = newNode;
-        } else {
-            tail->next = newNode;
+    void purgeLoop() {
+        unique_lock<mutex> guard(purgeLock);
+        while (!purgerStopping) {
+            if (purgeQueue.empty()) {
+                // Check for expired items once a minute when there is nothing to purge
+                if (!purgeWake.wait_for(guard, chrono::seconds(60),
+                                        [this] { return purgerStopping || !purgeQueue.empty(); })) {
+                    guard.unlock();
+                    expireOldItems();
+                    guard.lock();
+                }
+                continue;
+            }
+
+            PurgeJob job = move(purgeQueue.front());
+            purgeQueue.pop_front();
+            guard.unlock();
+            error_code ec;
+            fs::remove_all(job.path, ec);
+            if (ec) {
+                cerr << "Error purging " << job.path << ": " << ec.message() << endl;
+            } else {
+                purgedItems++;
+                reclaimedBytes += job.bytes;
+            }
+            guard.lock();
+        }
+    }
+
+    static void printItem(size_t number, const RecycleBinItem& item) {
+        cout << number << ". " << item.originalPath << "\n";
+        cout << "   Type: " << fileTypeToString(item.type) << "\n";
+        cout << "   Deleted: " << formatTime(item.deletionTime) << "\n";
+    }
+
+    // "<deletion time>_<id>_<path hash>_<name>": the id is unique for the
+    // lifetime of the bin, and the hash of the absolute original path tells
+    // same-named files from different directories apart at a glance.
+    static string backupNameFor(const RecycleBinItem& item) {
+        error_code ec;
+        fs::path absolute = fs::absolute(item.originalPath, ec);
+        string pathText = ec ? item.originalPath : absolute.lexically_normal().string();
+        uint32_t pathHash = 2166136261u; // FNV-1a
+        for (unsigned char c : pathText) {
+            pathHash = (pathHash ^ c) * 16777619u;
+        }
+        char hashText[9];
+        snprintf(hashText, sizeof(hashText), "%08x", pathHash);
+        return to_string(item.deletionTime) + "_" + to_string(item.id) + "_" + hashText + "_" +
+               fs::path(item.originalPath).filename().string();
+    }
+
+    // Recover the deletion time and file name from a backup name, in either
+    // the current format or the older "<deletion time>_<name>"
+    static bool parseBackupName(const string& name, time_t& deletionTime, string& filename) {
+        auto digitsUntil = [&](size_t from, size_t to) {
+            return to > from && all_of(name.begin() + from, name.begin() + to,
+                                       [](unsigned char c) { return isdigit(c) != 0; });
+        };
+        size_t timeEnd = name.find('_');
+        if (timeEnd == string::npos || timeEnd > 18 || !digitsUntil(0, timeEnd)) return false;
+        deletionTime = static_cast<time_t>(stoll(name.substr(0, timeEnd)));
+        filename = name.substr(timeEnd + 1);
+
+        size_t idEnd = name.find('_', timeEnd + 1);
+        size_t hashEnd = idEnd == string::npos ? string::npos : name.find('_', idEnd + 1);
+        if (hashEnd != string::npos && digitsUntil(timeEnd + 1, idEnd) && hashEnd - idEnd == 9 &&
+            all_of(name.begin() + idEnd + 1, name.begin() + hashEnd,
+                   [](unsigned char c) { return isxdigit(c) != 0; })) {
+            filename = name.substr(hashEnd + 1);
+        }
+        return true;
+    }
+
+    ItemIterator findByOriginalPath(const string& originalPath) {
+        auto range = byOriginalPath.equal_range(originalPath);
+        if (range.first == range.second) return items.end();
+        uint64_t newest = 0;
+        for (auto it = range.first; it != range.second; ++it) {
+            newest = max(newest, it->second);
+        }
+        return items.find(newest);
+    }
+
+    void insertItem(RecycleBinItem&& item) {
+        uint64_t id = item.id;
+        totalBytes += item.bytes;
+        byOriginalPath.emplace(item.originalPath, id);
+        byDeletionTime.emplace(item.deletionTime, id);
+        byBackupName.emplace(fs::path(item.backupPath).filename().string(), id);
+        items.emplace(id, move(item));
+    }
+
+    void unindexItem(const RecycleBinItem& item) {
+        auto range = byOriginalPath.equal_range(item.originalPath);
+        for (auto pathIt = range.first; pathIt != range.second; ++pathIt) {
+            if (pathIt->second == item.id) {
+                byOriginalPath.erase(pathIt);
+                break;
+            }
+        }
+        byDeletionTime.erase({item.deletionTime, item.id});
+        byBackupName.erase(fs::path(item.backupPath).filename().string());
+        totalBytes -= min(totalBytes, item.bytes);
+    }
+
+    // Drop an item from memory and log its removal
+    void eraseItem(ItemIterator it) {
+        string record(1, OP_REMOVE);
+        writeVarint(record, it->first);
+        unindexItem(it->second);
+        items.erase(it);
+        appendManifest({record});
+    }
+
+    bool restoreEntry(ItemIterator it) {
+        RecycleBinItem item = it->second;
+        try {
+            if (fs::exists(item.originalPath)) {
+                cout << "Original location already exists. Cannot restore.\n";
+                return false;
+            }
+
+            moveEntry(item.backupPath, item.originalPath);
+            eraseItem(it);
+            cout << "Restored: " << item.originalPath << "\n";
+            return true;
+        } catch (const exception& e) {
+            cerr << "Error restoring: " << e.what() << endl;
+            return false;
+        }
+    }
+
+    bool deleteEntry(ItemIterator it, bool permanent) {
+        RecycleBinItem item = it->second;
+        try {
+            if (permanent) {
+                if (item.type == DIRECTORY) {
+                    fs::remove_all(item.backupPath);
+                } else {
+                    fs::remove(item.backupPath);
+                }
+                cout << "Permanently deleted: " << item.originalPath << "\n";
+            } else {
+                cout << "Deleted: " << item.originalPath << "\n";
+            }
+            eraseItem(it);
+            return true;
+        } catch (const exception& e) {
+            cerr << "Error deleting: " << e.what() << endl;
+            return false;
+        }
+    }
+
+    static void encodeAdd(string& out, const RecycleBinItem& item) {
+        out.push_back(OP_ADD);
+        writeVarint(out, item.id);
+        writeVarint(out, static_cast<uint64_t>(item.deletionTime));
+        writeVarint(out, item.type);
+        writeVarint(out, item.bytes);
+        writeBytes(out, item.originalPath);
+        writeBytes(out, fs::path(item.backupPath).filename().string());
+    }
+
+    // Log records for changes already applied in memory, in one write. Once
+    // the log is mostly dead records it is rewritten instead.
+    void appendManifest(const vector<string>& records) {
+        if (manifestRecords + records.size() > max(MIN_COMPACTION_RECORDS, 2 * items.size())) {
+            writeManifest();
+            return;
+        }
+
+        string framed;
+        error_code ec;
+        if (fs::file_size(manifestPath, ec) == 0 || ec) {
+            framed = MANIFEST_MAGIC;
+        }
+        for (const string& record : records) {
+            appendFramedRecord(framed, record);
+        }
+#ifndef _WIN32
+        int fd = ::open(manifestPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        bool ok = fd >= 0 && writeAll(fd, framed) && fdatasync(fd) == 0;
+        if (fd >= 0) ::close(fd);
+#else
+        ofstream manifest(manifestPath, ios::binary | ios::app);
+        bool ok = static_cast<bool>(manifest.write(framed.data(), framed.size()).flush());
+#endif
+        if (!ok) {
+            cerr << "Error writing recycle bin manifest." << endl;
+        }
+        manifestRecords += records.size();
+    }
+
+    // Rewrite the manifest with one record per live item
+    void writeManifest() {
+        string data = MANIFEST_MAGIC;
+        for (const auto& entry : items) {
+            string record;
+            encodeAdd(record, entry.second);
+            appendFramedRecord(data, record);
+        }
+        if (!writeFileAtomically(manifestPath, data)) {
+            cerr << "Error writing recycle bin manifest." << endl;
+        }
+        manifestRecords = items.size();
+    }
+
+    void loadManifest() {
+        shared_ptr<const MappedFile> file = MappedFile::open(manifestPath);
+        string_view data = file->view();
+        size_t magicLength = strlen(MANIFEST_MAGIC);
+        if (data.size() >= magicLength && data.substr(0, magicLength) == MANIFEST_MAGIC) {
+            scanFramedRecords(data, magicLength, [&](char op, string_view payload) {
+                manifestRecords++;
+                const char* cursor = payload.data();
+                const char* end = payload.data() + payload.size();
+                uint64_t id, deletionTime, type, bytes;
+                if (!readVarint(cursor, end, id)) return;
+                nextItemId = max(nextItemId, id + 1);
+                if (op == OP_REMOVE) {
+                    auto it = items.find(id);
+                    if (it != items.end()) {
+                        totalBytes -= min(totalBytes, it->second.bytes);
+                        items.erase(it);
+                    }
+                    return;
+                }
+                RecycleBinItem item;
+                string backupName;
+                if (op != OP_ADD || !readVarint(cursor, end, deletionTime) || !readVarint(cursor, end, type) ||
+                    type > OTHER || !readVarint(cursor, end, bytes) || !readBytes(cursor, end, item.originalPath) ||
+                    !readBytes(cursor, end, backupName)) {
+                    return;
+                }
+                item.id = id;
+                item.deletionTime = static_cast<time_t>(deletionTime);
+                item.type = static_cast<FileType>(type);
+                item.bytes = bytes;
+                item.backupPath = binPath + "/" + backupName;
+                totalBytes += item.bytes;
+                items[id] = move(item);
+            });
+        }
+        file.reset();
+
+        for (auto& entry : items) {
+            const RecycleBinItem& item = entry.second;
+            byOriginalPath.emplace(item.originalPath, item.id);
+            byDeletionTime.emplace(item.deletionTime, item.id);
+            byBackupName.emplace(fs::path(item.backupPath).filename().string(), item.id);
+        }
+
+        if (rebuildFromDirectory() || manifestRecords > max(MIN_COMPACTION_RECORDS, 2 * items.size())) {
+            writeManifest();
+        }
+    }
+
+    // One pass over the bin directory: adopt backups the manifest does not
+    // list and drop entries whose backup has disappeared. Returns whether
+    // anything changed.
+    bool rebuildFromDirectory() {
+        vector<bool> seen(items.empty() ? 0 : items.rbegin()->first + 1, false);
+        size_t adopted = 0;
+        error_code ec;
+        for (fs::directory_iterator it(binPath, ec), end; !ec && it != end; it.increment(ec)) {
+            string name = it->path().filename().string();
+            if (name == MANIFEST_NAME || name == string(MANIFEST_NAME) + ".tmp" || name == PURGE_DIR_NAME) continue;
+
+            auto known = byBackupName.find(name);
+            if (known != byBackupName.end()) {
+                seen[known->second] = true;
+                continue;
+            }
+
+            RecycleBinItem item;
+            item.id = nextItemId++;
+            item.backupPath = binPath + "/" + name;
+            if (!parseBackupName(name, item.deletionTime, item.originalPath)) {
+                item.deletionTime = time(nullptr);
+                item.originalPath = name;
+            }
+            error_code typeError;
+            item.type = it->is_directory(typeError) ? DIRECTORY : getFileTypeFromExtension(item.originalPath);
+            item.bytes = measure(item.backupPath, item.type);
+            insertItem(move(item));
+            adopted++;
+        }
+
+        size_t dropped = 0;
+        for (auto it = items.begin(); it != items.end();) {
+            if (it->first < seen.size() && !seen[it->first]) {
+                unindexItem(it->second);
+                it = items.erase(it);
+                dropped++;
+            } else {
+                ++it;
+            }
+        }
+
+        if (adopted > 0 || dropped > 0) {
+            cout << "Recycle bin: recovered " << adopted << " untracked item(s), dropped "
+                 << dropped << " missing item(s).\n";
+        }
+        return adopted > 0 || dropped > 0;
+    }
+};
+
+// Tuning for parallel content search
+struct SearchOptions {
+    unsigned threads;  // 0 = one per available core
+    size_t chunkSize;  // Files handed to a worker at a time
+
+    SearchOptions() : threads(0), chunkSize(64) {}
+};
+
+// A file whose content matched a search, with where it matched
+struct ContentMatch {
+    static constexpr size_t MAX_OFFSETS = 8; // Offsets kept per file for display
+
+    FileNode* node;
+    size_t matchCount;
+    vector<size_t> offsets;
+};
+
+// Bounded LRU cache of file contents keyed by filename
+struct ContentCache {
+    struct Entry {
+        string filename;
+        shared_ptr<const MappedFile> content;
+    };
+
+    list<Entry> entries; // Most recently used first
+    unordered_map<string_view, list<Entry>::iterator> lookup; // Keys view Entry::filename
+    mutable mutex lock; // Parallel searches share the cache
+    size_t capacityBytes;
+    size_t usedBytes;
+    size_t hits;
+    size_t misses;
+
+    ContentCache(size_t capacity = 64 * 1024 * 1024) :
+        capacityBytes(capacity), usedBytes(0), hits(0), misses(0) {}
+
+    shared_ptr<const MappedFile> find(string_view filename) {
+        lock_guard<mutex> guard(lock);
+        auto it = lookup.find(filename);
+        if (it == lookup.end()) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->content;
+    }
+
+    // Content larger than the whole cache is handed back without being kept
+    shared_ptr<const MappedFile> put(string_view filename, shared_ptr<const MappedFile> shared) {
+        lock_guard<mutex> guard(lock);
+        eraseLocked(filename);
+        if (shared->size() > capacityBytes) return shared;
+
+        entries.push_front({string(filename), shared});
+        lookup[entries.front().filename] = entries.begin();
+        usedBytes += shared->size();
+        evict();
+        return shared;
+    }
+
+    void erase(string_view filename) {
+        lock_guard<mutex> guard(lock);
+        eraseLocked(filename);
+    }
+
+    void setCapacity(size_t bytes) {
+        lock_guard<mutex> guard(lock);
+        capacityBytes = bytes;
+        evict();
+    }
+
+    void clear() {
+        lock_guard<mutex> guard(lock);
+        entries.clear();
+        lookup.clear();
+        usedBytes = 0;
+    }
+
+private:
+    void eraseLocked(string_view filename) {
+        auto it = lookup.find(filename);
+        if (it == lookup.end()) return;
+        usedBytes -= it->second->content->size();
+        entries.erase(it->second);
+        lookup.erase(it);
+    }
+
+    void evict() {
+        while (usedBytes > capacityBytes && !entries.empty()) {
+            usedBytes -= entries.back().content->size();
+            lookup.erase(entries.back().filename);
+            entries.pop_back();
+        }
+    }
+};
+
+// Inverted full-text index: token -> (file id -> token positions).
+// File ids are FileNode::id values; tokens are lowercased runs of letters,
+// digits and non-ASCII bytes.
+struct InvertedIndex {
+    static constexpr size_t MAX_TOKEN_LENGTH = 64;
+    static constexpr const char* MAGIC = "FMIX1";
+
+    struct Document {
+        string filename;
+        uint64_t size;
+        long long modified;
+        vector<const string*> tokens; // Distinct tokens, pointing at postings keys
+    };
+
+    unordered_map<string, unordered_map<size_t, vector<uint32_t>>> postings;
+    unordered_map<size_t, Document> documents;
+    bool dirty;
+
+    InvertedIndex() : dirty(false) {}
+
+    static bool isTokenByte(unsigned char c) {
+        return isalnum(c) || c >= 0x80;
+    }
+
+    template <typename Visit>
+    static void tokenize(string_view text, Visit visit) {
+        string token;
+        uint32_t position = 0;
+        for (size_t i = 0; i <= text.size(); i++) {
+            unsigned char c = i < text.size() ? static_cast<unsigned char>(text[i]) : ' ';
+            if (isTokenByte(c)) {
+                token.push_back(static_cast<char>(tolower(c)));
+            } else if (!token.empty()) {
+                if (token.size() <= MAX_TOKEN_LENGTH) visit(token, position++);
+                token.clear();
+            }
+        }
+    }
+
+    void addDocument(size_t id, string_view filename, string_view content,
+                     uint64_t size, long long modified) {
+        removeDocument(id);
+        Document& document = documents[id];
+        document.filename = filename;
+        document.size = size;
+        document.modified = modified;
+
+        tokenize(content, [&](const string& token, uint32_t position) {
+            auto entry = postings.try_emplace(token).first;
+            vector<uint32_t>& positions = entry->second[id];
+            if (positions.empty()) document.tokens.push_back(&entry->first);
+            positions.push_back(position);
+        });
+        dirty = true;
+    }
+
+    void removeDocument(size_t id) {
+        auto it = documents.find(id);
+        if (it == documents.end()) return;
+
+        for (const string* token : it->second.tokens) {
+            auto entry = postings.find(*token);
+            entry->second.erase(id);
+            if (entry->second.empty()) postings.erase(entry);
+        }
+        documents.erase(it);
+        dirty = true;
+    }
+
+    void renameDocument(size_t id, const string& filename) {
+        auto it = documents.find(id);
+        if (it != documents.end()) {
+            it->second.filename = filename;
+            dirty = true;
+        }
+    }
+
+    bool contains(size_t id) const { return documents.count(id) != 0; }
+
+    void clear() {
+        postings.clear();
+        documents.clear();
+        dirty = true;
+    }
+
+    // Files containing the query's tokens as a consecutive phrase, with the
+    // number of occurrences in each. A single-token query is a keyword lookup.
+    vector<pair<size_t, size_t>> query(string_view text) const {
+        vector<const unordered_map<size_t, vector<uint32_t>>*> terms;
+        bool missing = false;
+        tokenize(text, [&](const string& token, uint32_t) {
+            auto entry = postings.find(token);
+            if (entry == postings.end()) {
+                missing = true;
+            } else {
+                terms.push_back(&entry->second);
+            }
+        });
+
+        vector<pair<size_t, size_t>> results;
+        if (terms.empty() || missing) return results;
+
+        // Drive the intersection from the rarest term
+        size_t rarest = 0;
+        for (size_t i = 1; i < terms.size(); i++) {
+            if (terms[i]->size() < terms[rarest]->size()) rarest = i;
+        }
+
+        for (const auto& candidate : *terms[rarest]) {
+            size_t id = candidate.first;
+            vector<const vector<uint32_t>*> lists;
+            for (const auto* term : terms) {
+                auto found = term->find(id);
+                if (found == term->end()) break;
+                lists.push_back(&found->second);
+            }
+            if (lists.size() != terms.size()) continue;
+
+            size_t occurrences = 0;
+            for (uint32_t start : *lists[0]) {
+                bool phrase = true;
+                for (size_t t = 1; t < lists.size() && phrase; t++) {
+                    phrase = binary_search(lists[t]->begin(), lists[t]->end(), start + t);
+                }
+                if (phrase) occurrences++;
+            }
+            if (occurrences > 0) results.push_back({id, occurrences});
+        }
+        return results;
+    }
+
+    // Layout: magic, document table (name, size, modified), then for each token
+    // its bytes and postings as delta-encoded document ordinals, each followed
+    // by its delta-encoded positions. Everything is varint encoded.
+    bool save(const string& path) {
+        string out(MAGIC);
+        unordered_map<size_t, uint64_t> ordinals;
+        writeVarint(out, documents.size());
+        for (const auto& entry : documents) {
+            ordinals[entry.first] = ordinals.size();
+            writeBytes(out, entry.second.filename);
+            writeVarint(out, entry.second.size);
+            writeVarint(out, static_cast<uint64_t>(entry.second.modified));
+        }
+
+        writeVarint(out, postings.size());
+        vector<pair<uint64_t, const vector<uint32_t>*>> sorted;
+        for (const auto& entry : postings) {
+            writeBytes(out, entry.first);
+            sorted.clear();
+            for (const auto& posting : entry.second) {
+                sorted.push_back({ordinals[posting.first], &posting.second});
+            }
+            sort(sorted.begin(), sorted.end());
+
+            writeVarint(out, sorted.size());
+            uint64_t previousOrdinal = 0;
+            for (const auto& posting : sorted) {
+                writeVarint(out, posting.first - previousOrdinal);
+                previousOrdinal = posting.first;
+                writeVarint(out, posting.second->size());
+                uint32_t previousPosition = 0;
+                for (uint32_t position : *posting.second) {
+                    writeVarint(out, position - previousPosition);
+                    previousPosition = position;
+                }
+            }
+        }
+
+        if (!writeFileAtomically(path, out)) return false;
+        dirty = false;
+        return true;
+    }
+
+    // resolve maps a stored filename to the current file id, or returns false
+    // when the document is gone or stale; such documents are skipped.
+    bool load(const string& path, const function<bool(const Document&, size_t&)>& resolve) {
+        shared_ptr<const MappedFile> file = MappedFile::open(path);
+        string_view data = file->view();
+        size_t magicLength = strlen(MAGIC);
+        if (data.substr(0, magicLength) != MAGIC) return false;
+
+        const char* cursor = data.data() + magicLength;
+        const char* end = data.data() + data.size();
+        clear();
+
+        uint64_t documentCount;
+        if (!readVarint(cursor, end, documentCount)) return false;
+        vector<size_t> ids;
+        vector<bool> live;
+        for (uint64_t i = 0; i < documentCount; i++) {
+            Document document;
+            uint64_t modified;
+            if (!readBytes(cursor, end, document.filename) ||
+                !readVarint(cursor, end, document.size) ||
+                !readVarint(cursor, end, modified)) {
+                clear();
+                return false;
+            }
+            document.modified = static_cast<long long>(modified);
+
+            size_t id = 0;
+            bool keep = resolve(document, id);
+            ids.push_back(id);
+            live.push_back(keep);
+            if (keep) documents[id] = move(document);
+        }
+
+        uint64_t tokenCount;
+        if (!readVarint(cursor, end, tokenCount)) {
+            clear();
+            return false;
+        }
+        string token;
+        for (uint64_t t = 0; t < tokenCount; t++) {
+            uint64_t postingCount;
+            if (!readBytes(cursor, end, token) || !readVarint(cursor, end, postingCount)) {
+                clear();
+                return false;
+            }
+
+            unordered_map<size_t, vector<uint32_t>>* entry = nullptr;
+            const string* key = nullptr;
+            uint64_t ordinal = 0;
+            for (uint64_t p = 0; p < postingCount; p++) {
+                uint64_t delta, positionCount;
+                if (!readVarint(cursor, end, delta) || !readVarint(cursor, end, positionCount)) {
+                    clear();
+                    return false;
+                }
+                ordinal += delta;
+                if (ordinal >= documentCount) {
+                    clear();
+                    return false;
+                }
+
+                vector<uint32_t>* positions = nullptr;
+                if (live[ordinal]) {
+                    if (!entry) {
+                        auto inserted = postings.try_emplace(token).first;
+                        entry = &inserted->second;
+                        key = &inserted->first;
+                    }
+                    positions = &(*entry)[ids[ordinal]];
+                    positions->reserve(positionCount);
+                    documents[ids[ordinal]].tokens.push_back(key);
+                }
+
+                uint64_t position = 0;
+                for (uint64_t k = 0; k < positionCount; k++) {
+                    uint64_t step;
+                    if (!readVarint(cursor, end, step)) {
+                        clear();
+                        return false;
+                    }
+                    position += step;
+                    if (positions) positions->push_back(static_cast<uint32_t>(position));
+                }
+            }
+        }
+        dirty = false;
+        return true;
+    }
+};
+
+// Compressed radix tree over filenames. Prefix queries cost O(|prefix| + k)
+// and visit matches in lexicographic order.
+struct RadixTree {
+    struct Node {
+        string label; // Edge label from the parent
+        FileNode* file; // Set when a filename ends at this node
+        map<unsigned char, unique_ptr<Node>> children;
+
+        Node() : file(nullptr) {}
+    };
+
+    Node root;
+    size_t entries;
+    vector<pair<Node*, unsigned char>> path; // Scratch for erase: parent and edge taken, reused across calls
+
+    RadixTree() : entries(0) {}
+
+    void insert(string_view key, FileNode* file) {
+        Node* node = &root;
+        size_t i = 0;
+        while (i < key.size()) {
+            auto it = node->children.find(static_cast<unsigned char>(key[i]));
+            if (it == node->children.end()) {
+                auto leaf = make_unique<Node>();
+                leaf->label = key.substr(i);
+                leaf->file = file;
+                node->children.emplace(static_cast<unsigned char>(key[i]), move(leaf));
+                entries++;
+                return;
+            }
+
+            Node* child = it->second.get();
+            size_t common = 0;
+            while (common < child->label.size() && i + common < key.size() &&
+                   child->label[common] == key[i + common]) {
+                common++;
+            }
+
+            if (common < child->label.size()) {
+                // Split the edge at the point where the key diverges
+                auto middle = make_unique<Node>();
+                middle->label = child->label.substr(0, common);
+                unique_ptr<Node> lower = move(it->second);
+                lower->label.erase(0, common);
+                middle->children.emplace(static_cast<unsigned char>(lower->label[0]), move(lower));
+                it->second = move(middle);
+                child = it->second.get();
+            }
+            node = child;
+            i += common;
+        }
+
+        if (!node->file) entries++;
+        node->file = file;
+    }
+
+    bool erase(string_view key) {
+        path.clear();
+        Node* node = &root;
+        size_t i = 0;
+        while (i < key.size()) {
+            auto it = node->children.find(static_cast<unsigned char>(key[i]));
+            if (it == node->children.end()) return false;
+            Node* child = it->second.get();
+            if (key.compare(i, child->label.size(), child->label) != 0) return false;
+            path.push_back({node, it->first});
+            node = child;
+            i += child->label.size();
+        }
+        if (!node->file) return false;
+
+        node->file = nullptr;
+        entries--;
+
+        if (path.empty()) return true;
+        Node* parent = path.back().first;
+        if (node->children.empty()) {
+            parent->children.erase(path.back().second);
+            if (parent != &root && !parent->file && parent->children.size() == 1) {
+                mergeWithOnlyChild(parent);
+            }
+        } else if (node->children.size() == 1) {
+            mergeWithOnlyChild(node);
+        }
+        return true;
+    }
+
+    // Visit up to limit files whose name starts with prefix (limit 0 = all)
+    template <typename Visit>
+    size_t forEachWithPrefix(const string& prefix, size_t limit, Visit visit) const {
+        const Node* node = &root;
+        size_t i = 0;
+        while (i < prefix.size()) {
+            auto it = node->children.find(static_cast<unsigned char>(prefix[i]));
+            if (it == node->children.end()) return 0;
+            const Node* child = it->second.get();
+            size_t length = min(child->label.size(), prefix.size() - i);
+            if (prefix.compare(i, length, child->label, 0, length) != 0) return 0;
+            node = child;
+            i += length;
+        }
+
+        size_t visited = 0;
+        vector<const Node*> stack{node};
+        while (!stack.empty() && (limit == 0 || visited < limit)) {
+            const Node* current = stack.back();
+            stack.pop_back();
+            if (current->file) {
+                visit(current->file);
+                visited++;
+            }
+            for (auto it = current->children.rbegin(); it != current->children.rend(); ++it) {
+                stack.push_back(it->second.get());
+            }
+        }
+        return visited;
+    }
+
+    void clear() {
+        root.children.clear();
+        root.file = nullptr;
+        entries = 0;
+    }
+
+private:
+    static void mergeWithOnlyChild(Node* node) {
+        unique_ptr<Node> child = move(node->children.begin()->second);
+        node->children.clear();
+        node->label += child->label;
+        node->file = child->file;
+        node->children = move(child->children);
+    }
+};
+
+// Open-addressing hash index from filename to node, kept alongside the list
+struct FileNameIndex {
+    enum SlotState : unsigned char { EMPTY, USED, DELETED };
+
+    struct Slot {
+        size_t hash;
+        FileNode* node;
+        SlotState state;
+    };
+
+    vector<Slot> slots;
+    size_t used;   // live entries
+    size_t filled; // live entries plus tombstones
+
+    FileNameIndex() : used(0), filled(0) {}
+
+    static size_t hashName(string_view filename) {
+        return hash<string_view>{}(filename);
+    }
+
+    FileNode* find(string_view filename) const {
+        if (slots.empty()) return nullptr;
+
+        size_t h = hashName(filename);
+        size_t mask = slots.size() - 1;
+        for (size_t i = h & mask; ; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.state == EMPTY) return nullptr;
+            if (slot.state == USED && slot.hash == h && slot.node->filename == filename) {
+                return slot.node;
+            }
+        }
+    }
+
+    void insert(FileNode* node) {
+        if ((filled + 1) * 10 >= slots.size() * 7) {
+            rehash(max<size_t>(16, (used + 1) * 2));
+        }
+
+        size_t h = hashName(node->filename);
+        size_t mask = slots.size() - 1;
+        size_t target = slots.size();
+        for (size_t i = h & mask; ; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (slot.state == EMPTY) {
+                if (target == slots.size()) {
+                    target = i;
+                    filled++;
+                }
+                break;
+            }
+            if (slot.state == DELETED) {
+                if (target == slots.size()) target = i;
+            } else if (slot.hash == h && slot.node->filename == node->filename) {
+                slot.node = node; // already indexed, repoint
+                return;
+            }
+        }
+        slots[target] = {h, node, USED};
+        used++;
+    }
+
+    bool erase(string_view filename) {
+        if (slots.empty()) return false;
+
+        size_t h = hashName(filename);
+        size_t mask = slots.size() - 1;
+        for (size_t i = h & mask; ; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (slot.state == EMPTY) return false;
+            if (slot.state == USED && slot.hash == h && slot.node->filename == filename) {
+                slot.state = DELETED;
+                slot.node = nullptr;
+                used--;
+                return true;
+            }
+        }
+    }
+
+    // Grow the table so that n entries fit without further rehashing
+    void reserve(size_t n) {
+        if ((n + 1) * 10 >= slots.size() * 7) {
+            rehash(n * 2);
+        }
+    }
+
+    void clear() {
+        slots.clear();
+        used = filled = 0;
+    }
+
+    size_t size() const { return used; }
+
+private:
+    void rehash(size_t minCapacity) {
+        size_t capacity = 16;
+        while (capacity < minCapacity) capacity <<= 1;
+
+        vector<Slot> old;
+        old.swap(slots);
+        slots.assign(capacity, Slot{0, nullptr, EMPTY});
+        filled = used;
+
+        size_t mask = capacity - 1;
+        for (const Slot& slot : old) {
+            if (slot.state != USED) continue;
+            size_t i = slot.hash & mask;
+            while (slots[i].state != EMPTY) i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+};
+
+// Order-statistic index over the list: an implicit treap keyed by position,
+// stored in the nodes themselves. Finding the node at an index, inserting at
+// an index and unlinking a node are O(log n) expected; the linked list keeps
+// serving in-order walks.
+struct PositionIndex {
+    FileNode* root;
+    uint32_t seed;
+
+    PositionIndex() : root(nullptr), seed(2463534242u) {}
+
+    uint32_t nextPriority() {
+        // xorshift32
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    static int sizeOf(const FileNode* node) {
+        return node ? node->treeSize : 0;
+    }
+
+    static void update(FileNode* node) {
+        node->treeSize = 1 + sizeOf(node->treeLeft) + sizeOf(node->treeRight);
+        if (node->treeLeft) node->treeLeft->treeParent = node;
+        if (node->treeRight) node->treeRight->treeParent = node;
+    }
+
+    // All of a's nodes come before b's
+    static FileNode* merge(FileNode* a, FileNode* b) {
+        if (!a) return b;
+        if (!b) return a;
+        if (a->treePriority > b->treePriority) {
+            a->treeRight = merge(a->treeRight, b);
+            update(a);
+            return a;
+        }
+        b->treeLeft = merge(a, b->treeLeft);
+        update(b);
+        return b;
+    }
+
+    // The first k nodes go to left, the rest to right
+    static void split(FileNode* node, int k, FileNode*& left, FileNode*& right) {
+        if (!node) {
+            left = right = nullptr;
+            return;
+        }
+        node->treeParent = nullptr;
+        if (sizeOf(node->treeLeft) < k) {
+            split(node->treeRight, k - sizeOf(node->treeLeft) - 1, node->treeRight, right);
+            left = node;
+        } else {
+            split(node->treeLeft, k, left, node->treeLeft);
+            right = node;
+        }
+        update(node);
+        if (left) left->treeParent = nullptr;
+        if (right) right->treeParent = nullptr;
+    }
+
+    void insert(FileNode* node, int position) {
+        node->treeLeft = node->treeRight = node->treeParent = nullptr;
+        node->treeSize = 1;
+        node->treePriority = nextPriority();
+
+        // Descend to where the new node's priority belongs, then split only
+        // the subtree below that point
+        FileNode** link = &root;
+        FileNode* parent = nullptr;
+        while (*link && (*link)->treePriority > node->treePriority) {
+            parent = *link;
+            parent->treeSize++;
+            int leftSize = sizeOf(parent->treeLeft);
+            if (position <= leftSize) {
+                link = &parent->treeLeft;
+            } else {
+                position -= leftSize + 1;
+                link = &parent->treeRight;
+            }
+        }
+        split(*link, position, node->treeLeft, node->treeRight);
+        update(node);
+        node->treeParent = parent;
+        *link = node;
+    }
+
+    void erase(FileNode* node) {
+        FileNode* replacement = merge(node->treeLeft, node->treeRight);
+        FileNode* parent = node->treeParent;
+        if (replacement) replacement->treeParent = parent;
+        if (!parent) {
+            root = replacement;
+        } else if (parent->treeLeft == node) {
+            parent->treeLeft = replacement;
+        } else {
+            parent->treeRight = replacement;
+        }
+        for (; parent; parent = parent->treeParent) {
+            parent->treeSize--;
+        }
+        node->treeLeft = node->treeRight = node->treeParent = nullptr;
+        node->treeSize = 1;
+    }
+
+    FileNode* at(int index) const {
+        FileNode* node = root;
+        while (node) {
+            int leftSize = sizeOf(node->treeLeft);
+            if (index < leftSize) {
+                node = node->treeLeft;
+            } else if (index == leftSize) {
+                return node;
+            } else {
+                index -= leftSize + 1;
+                node = node->treeRight;
+            }
+        }
+        return nullptr;
+    }
+
+    static int indexOf(const FileNode* node) {
+        int index = sizeOf(node->treeLeft);
+        for (; node->treeParent; node = node->treeParent) {
+            if (node->treeParent->treeRight == node) {
+                index += sizeOf(node->treeParent->treeLeft) + 1;
+            }
+        }
+        return index;
+    }
+
+    // Rebuild from the list order in O(n), e.g. after the list was re-sorted:
+    // nodes are pushed along the right spine of a Cartesian tree
+    void rebuild(FileNode* head) {
+        vector<FileNode*> spine;
+        for (FileNode* node = head; node; node = node->next) {
+            node->treeLeft = node->treeRight = node->treeParent = nullptr;
+            node->treeSize = 1;
+            node->treePriority = nextPriority();
+            FileNode* last = nullptr;
+            while (!spine.empty() && spine.back()->treePriority < node->treePriority) {
+                // A popped subtree is complete; its right child was popped just before it
+                last = spine.back();
+                spine.pop_back();
+                update(last);
+            }
+            node->treeLeft = last;
+            update(node);
+            if (!spine.empty()) spine.back()->treeRight = node;
+            spine.push_back(node);
+        }
+        // Fix sizes along the final right spine, bottom up
+        for (size_t i = spine.size(); i-- > 0;) {
+            update(spine[i]);
+        }
+        root = spine.empty() ? nullptr : spine.front();
+        if (root) root->treeParent = nullptr;
+    }
+
+    void clear() {
+        root = nullptr;
+    }
+};
+
+// Bump allocator for filenames. Names are copied into large blocks with a
+// trailing NUL, so nodes hold only a view and the whole arena is released at
+// once. Names dropped by renames and removals are only counted as dead; the
+// owner copies the live ones into a fresh arena once needsCompaction().
+struct StringArena {
+    static constexpr size_t BLOCK_BYTES = 64 * 1024;
+    static constexpr size_t MIN_DEAD_BYTES = 1024 * 1024; // Before a compaction is worth it
+
+    vector<unique_ptr<char[]>> blocks;
+    size_t blockUsed;
+    size_t blockCapacity;
+    size_t blocksReserved; // Capacities of all blocks summed; oversized ones differ from BLOCK_BYTES
+    size_t bytesUsed; // Live and dead
+    size_t deadBytes;
+    size_t blockAllocations; // Over the arena's lifetime
+    size_t compactions;
+
+    StringArena() : blockUsed(0), blockCapacity(0), blocksReserved(0), bytesUsed(0), deadBytes(0),
+                    blockAllocations(0), compactions(0) {}
+
+    string_view intern(string_view text) {
+        size_t needed = text.size() + 1;
+        if (blockUsed + needed > blockCapacity) {
+            // Oversized names get a block of their own
+            size_t capacity = max(BLOCK_BYTES, needed);
+            blocks.emplace_back(new char[capacity]);
+            blockAllocations++;
+            blockUsed = 0;
+            blockCapacity = capacity;
+            blocksReserved += capacity;
+        }
+        char* out = blocks.back().get() + blockUsed;
+        memcpy(out, text.data(), text.size());
+        out[text.size()] = '\0';
+        blockUsed += needed;
+        bytesUsed += needed;
+        return string_view(out, text.size());
+    }
+
+    // A name interned here is no longer referenced
+    void release(string_view text) {
+        deadBytes += text.size() + 1;
+    }
+
+    bool needsCompaction() const {
+        return deadBytes >= MIN_DEAD_BYTES && deadBytes * 2 >= bytesUsed;
+    }
+
+    size_t reservedBytes() const {
+        return blocksReserved;
+    }
+
+    void clear() {
+        blocks.clear();
+        blockUsed = blockCapacity = blocksReserved = bytesUsed = deadBytes = 0;
+    }
+};
+
+// Allocations made by one kind of catalog operation
+struct AllocationStats {
+    size_t operations = 0;
+    size_t allocations = 0;
+
+    double perOperation() const {
+        return operations ? static_cast<double>(allocations) / operations : 0.0;
+    }
+};
+
+// Charges the heap allocations made during its lifetime to `stats`. Other
+// threads allocating meanwhile are counted too, so figures are approximate
+// while background work runs.
+struct AllocationMeter {
+    AllocationStats& stats;
+    size_t operations;
+    size_t start;
+
+    explicit AllocationMeter(AllocationStats& target, size_t count = 1) :
+        stats(target), operations(count), start(heapAllocations.load(memory_order_relaxed)) {}
+
+    ~AllocationMeter() {
+        stats.operations += operations;
+        stats.allocations += heapAllocations.load(memory_order_relaxed) - start;
+    }
+};
+
+// Slab allocator for FileNode. Nodes are carved out of fixed-size slabs and
+// recycled through a free list threaded through their `next` links; clear()
+// hands every slab back at once. FileNode owns no heap memory, so releasing
+// a slab needs no per-node destructor calls.
+struct NodePool {
+    static constexpr size_t SLAB_NODES = 1024;
+
+    vector<FileNode*> slabs;
+    size_t slabUsed; // Nodes handed out from the newest slab
+    FileNode* freeList;
+    size_t liveNodes;
+    size_t slabAllocations; // Over the pool's lifetime
+
+    NodePool() : slabUsed(SLAB_NODES), freeList(nullptr), liveNodes(0), slabAllocations(0) {}
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool() {
+        clear();
+    }
+
+    template <typename... Args>
+    FileNode* create(Args&&... args) {
+        void* slot;
+        if (freeList) {
+            slot = freeList;
+            freeList = freeList->next;
+        } else {
+            if (slabUsed == SLAB_NODES) {
+                slabs.push_back(static_cast<FileNode*>(::operator new(SLAB_NODES * sizeof(FileNode))));
+                slabAllocations++;
+                slabUsed = 0;
+            }
+            slot = slabs.back() + slabUsed++;
+        }
+        liveNodes++;
+        return new (slot) FileNode(forward<Args>(args)...);
+    }
+
+    void destroy(FileNode* node) {
+        static_assert(is_trivially_destructible<FileNode>::value, "slabs are released without destructors");
+        node->next = freeList;
+        freeList = node;
+        liveNodes--;
+    }
+
+    void clear() {
+        for (FileNode* slab : slabs) {
+            ::operator delete(slab);
+        }
+        slabs.clear();
+        slabUsed = SLAB_NODES;
+        freeList = nullptr;
+        liveNodes = 0;
+    }
+};
+
+// Doubly linked list for file management
+struct FileList {
+
+    FileNode* head;
+    FileNode* tail;
+    int count;
+    FileNameIndex nameIndex;
+    RadixTree nameTree;
+    // Ordered secondary indexes keyed by (size, id) and (lastModified, id)
+    map<pair<size_t, size_t>, FileNode*> sizeIndex;
+    map<pair<time_t, size_t>, FileNode*> modifiedIndex;
+    size_t nextNodeId;
+    ContentCache contentCache;
+    SearchOptions searchOptions;
+    unique_ptr<ThreadPool> searchPool; // Created on first parallel search
+    InvertedIndex contentIndex;
+    bool contentIndexEnabled;
+    PositionIndex positions; // O(log n) access by list position
+    StringArena names; // Filename storage for every node
+    NodePool nodePool;
+    // Per-operation allocation counts; loads count one operation per entry
+    AllocationStats addAllocations, removeAllocations, renameAllocations, loadAllocations;
+
+    // Detach and return the chain that follows the first n nodes of a run
+    static FileNode* splitAfter(FileNode* node, int n) {
+        for (int i = 1; node && i < n; i++) {
+            node = node->next;
+        }
+        if (!node) return nullptr;
+
+        FileNode* rest = node->next;
+        node->next = nullptr;
+        return rest;
+    }
+
+    // Merge two sorted runs onto *out, preferring the left run on ties.
+    // Returns the link slot after the last merged node.
+    template <typename Less>
+    static FileNode** mergeRuns(FileNode* left, FileNode* right, FileNode** out, Less& less) {
+        while (left && right) {
+            if (less(*right, *left)) {
+                *out = right;
+                right = right->next;
+            } else {
+                *out = left;
+                left = left->next;
+            }
+            out = &(*out)->next;
+        }
+        *out = left ? left : right;
+        while (*out) {
+            out = &(*out)->next;
+        }
+        return out;
+    }
+
+    FileList() : head(nullptr), tail(nullptr), count(0), nextNodeId(1), contentIndexEnabled(false) {}
+    
+    ~FileList() {
+        clear();
+    }
+
+    bool isEmpty() const { return head == nullptr; }
+    int size() const { return count; }
+
+    bool contains(const string& filename) const {
+        return nameIndex.find(filename) != nullptr;
+    }
+
+    // Allocate a node and register it with every index
+    FileNode* createNode(const string& filename) {
+        AllocationMeter meter(addAllocations);
+        return registerNode(nodePool.create(names.intern(filename)));
+    }
+
+    FileNode* createNode(const string& filename, FileType type, size_t size,
+                         time_t created, time_t modified) {
+        AllocationMeter meter(addAllocations);
+        return registerNode(nodePool.create(names.intern(filename), type, size, created, modified));
+    }
+
+    FileNode* registerNode(FileNode* node) {
+        node->id = nextNodeId++;
+        nameIndex.insert(node);
+        nameTree.insert(node->filename, node);
+        indexStats(node);
+        return node;
+    }
+
+    // Drop an already unlinked node from every index and free it
+    void destroyNode(FileNode* node) {
+        AllocationMeter meter(removeAllocations);
+        nameIndex.erase(node->filename);
+        nameTree.erase(node->filename);
+        contentCache.erase(node->filename);
+        contentIndex.removeDocument(node->id);
+        unindexStats(node);
+        names.release(node->filename);
+        nodePool.destroy(node);
+    }
+
+    void indexStats(FileNode* node) {
+        sizeIndex.emplace(make_pair(node->size, node->id), node);
+        modifiedIndex.emplace(make_pair(node->lastModified, node->id), node);
+    }
+
+    void unindexStats(FileNode* node) {
+        sizeIndex.erase(make_pair(node->size, node->id));
+        modifiedIndex.erase(make_pair(node->lastModified, node->id));
+    }
+
+    // Refresh a node's stats and re-key it in the ordered indexes
+    void refreshFileStats(FileNode* node) {
+        refreshFileStats(node, fileSizeOnDisk(node->filename));
+    }
+
+    void refreshFileStats(FileNode* node, size_t newSize) {
+        unindexStats(node);
+        node->updateFileStats(newSize);
+        indexStats(node);
+    }
+
+    // Apply stats recorded elsewhere, e.g. replayed from the catalog journal
+    void setFileStats(FileNode* node, size_t size, time_t modified) {
+        unindexStats(node);
+        node->size = (node->type == DIRECTORY) ? 0 : size;
+        node->lastModified = modified;
+        indexStats(node);
+    }
+
+    bool renameFile(FileNode* node, const string& newName) {
+        if (contains(newName)) return false;
+        AllocationMeter meter(renameAllocations);
+        nameIndex.erase(node->filename);
+        nameTree.erase(node->filename);
+        contentCache.erase(node->filename);
+        names.release(node->filename);
+        node->filename = names.intern(newName);
+        nameIndex.insert(node);
+        nameTree.insert(newName, node);
+        contentIndex.renameDocument(node->id, newName);
+        return true;
+    }
+
+    // Link a node into the list at position (0..count); the caller has
+    // already checked the name and the position.
+    void linkNode(FileNode* newNode, int position) {
+        if (isEmpty()) {
+            head = tail = newNode;
+        } else if (position == 0) {
+            newNode->next = head;
+            head->prev = newNode;
+            head = newNode;
+        } else if (position == count) {
+            tail->next = newNode;
             newNode->prev = tail;
             tail = newNode;
+        } else {
+            FileNode* current = positions.at(position - 1);
+            newNode->next = current->next;
+            newNode->prev = current;
+            current->next->prev = newNode;
+            current->next = newNode;
+        }
+        positions.insert(newNode, position);
+        count++;
+    }
+
+    void addFileAtBeginning(const string& filename) {
+        if (contains(filename)) {
+            cout << "File '" << filename << "' already exists.\n";
+            return;
+        }
+        linkNode(createNode(filename), 0);
+    }
+
+    void addFileAtEnd(const string& filename) {
+        if (contains(filename)) {
+            cout << "File '" << filename << "' already exists.\n";
+            return;
+        }
+        linkNode(createNode(filename), count);
+    }
+
+    void addFileAtPosition(const string& filename, int position) {
+        if (position < 0 || position > count) {
+            cout << "Invalid position.\n";
+            return;
+        }
+
+        if (contains(filename)) {
+            cout << "File '" << filename << "' already exists.\n";
+            return;
+        }
+        linkNode(createNode(filename), position);
+    }
+
+    // Append many entries in one pass: the name index is sized once, nodes are
+    // linked at the tail without walking, and the ordered indexes are filled
+    // from sorted runs. Duplicate names are skipped. Returns the number added.
+    // Nodes are created and deduplicated on this thread; the radix tree,
+    // position treap and ordered indexes do not share state and are built
+    // concurrently when a pool is given.
+    size_t appendRecords(const vector<CatalogRecord>& records, ThreadPool* pool = nullptr) {
+        size_t allocationsBefore = heapAllocations.load(memory_order_relaxed);
+        nameIndex.reserve(nameIndex.size() + records.size());
+
+        vector<FileNode*> added;
+        added.reserve(records.size());
+        for (const CatalogRecord& record : records) {
+            if (contains(record.filename)) continue;
+
+            FileNode* node = nodePool.create(names.intern(record.filename), record.type, record.size,
+                                             record.created, record.modified);
+            node->id = nextNodeId++;
+            nameIndex.insert(node);
+            if (tail) {
+                tail->next = node;
+                node->prev = tail;
+            } else {
+                head = node;
+            }
+            tail = node;
+            added.push_back(node);
+        }
+
+        size_t previousCount = count;
+        count += static_cast<int>(added.size());
+
+        vector<function<void()>> steps;
+        steps.push_back([this, &added] {
+            for (FileNode* node : added) nameTree.insert(node->filename, node);
+        });
+        steps.push_back([this, &added, previousCount] {
+            // Rebuilding the position treap is linear; inserting is O(log n) each
+            if (added.size() * 8 > static_cast<size_t>(count)) {
+                positions.rebuild(head);
+            } else {
+                for (size_t i = 0; i < added.size(); i++) {
+                    positions.insert(added[i], static_cast<int>(previousCount + i));
+                }
+            }
+        });
+        steps.push_back([this, &added] {
+            fillOrderedIndex(sizeIndex, added, [](const FileNode* node) { return node->size; });
+        });
+        steps.push_back([this, &added] {
+            fillOrderedIndex(modifiedIndex, added, [](const FileNode* node) { return node->lastModified; });
+        });
+        if (contentIndexEnabled) {
+            // Only the keyword index and content cache are touched here
+            steps.push_back([this, &added] {
+                for (FileNode* node : added) indexContent(node);
+            });
+        }
+
+        if (pool && added.size() >= 4096) {
+            for (function<void()>& step : steps) pool->submit(step);
+            pool->wait();
+        } else {
+            for (function<void()>& step : steps) step();
+        }
+        loadAllocations.operations += added.size();
+        loadAllocations.allocations += heapAllocations.load(memory_order_relaxed) - allocationsBefore;
+        return added.size();
+    }
+
+    // Copy the live names into a fresh arena and repoint the nodes, returning
+    // the space of names dropped since the last compaction. Only the nodes
+    // view the arena; every index keys on its own copy or on the node.
+    void compactNames() {
+        StringArena compacted;
+        for (FileNode* current = head; current; current = current->next) {
+            current->filename = compacted.intern(current->filename);
+        }
+        compacted.blockAllocations += names.blockAllocations;
+        compacted.compactions = names.compactions + 1;
+        names = move(compacted);
+    }
+
+    // Keys are sorted in a flat array first, so the map is filled in order
+    // with end hints and the sort does not chase node pointers
+    template <typename Key, typename KeyOf>
+    static void fillOrderedIndex(map<pair<Key, size_t>, FileNode*>& index,
+                                 const vector<FileNode*>& nodes, KeyOf keyOf) {
+        vector<pair<pair<Key, size_t>, FileNode*>> entries;
+        entries.reserve(nodes.size());
+        for (FileNode* node : nodes) {
+            entries.push_back({make_pair(keyOf(node), node->id), node});
+        }
+        sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+        for (const auto& entry : entries) {
+            index.emplace_hint(index.end(), entry.first, entry.second);
+        }
+    }
+
+    // Add an entry whose metadata is already known, e.g. from the catalog,
+    // without touching the filesystem. Position -1 appends.
+    FileNode* addRecord(const string& filename, FileType type, size_t size,
+                        time_t created, time_t modified, int position = -1) {
+        if (position == -1) position = count;
+        if (position < 0 || position > count || contains(filename)) return nullptr;
+
+        FileNode* node = createNode(filename, type, size, created, modified);
+        linkNode(node, position);
+        return node;
+    }
+
+    void removeFileFromBeginning() {
+        if (isEmpty()) {
+            cout << "List is empty.\n";
+            return;
+        }
+
+        FileNode* temp = head;
+        if (head == tail) {
+            head = tail = nullptr;
+        } else {
+            head = head->next;
+            head->prev = nullptr;
+        }
+        
+        cout << "File '" << temp->filename << "' removed from beginning.\n";
+        positions.erase(temp);
+        destroyNode(temp);
+        count--;
+    }
+
+    void removeFileFromEnd() {
+        if (isEmpty()) {
+            cout << "List is empty.\n";
+            return;
+        }
+
+        FileNode* temp = tail;
+        if (head == tail) {
+            head = tail = nullptr;
+        } else {
+            tail = tail->prev;
+            tail->next = nullptr;
+        }
+        
+        cout << "File '" << temp->filename << "' removed from end.\n";
+        positions.erase(temp);
+        destroyNode(temp);
+        count--;
+    }
+
+    void removeFileFromPosition(int position) {
+        if (position < 0 || position >= count) {
+            cout << "Invalid position.\n";
+            return;
+        }
+
+        if (position == 0) {
+            removeFileFromBeginning();
+            return;
+        }
+
+        if (position == count - 1) {
+            removeFileFromEnd();
+            return;
+        }
+
+        FileNode* current = positions.at(position);
+        
+        current->prev->next = current->next;
+        current->next->prev = current->prev;
+        
+        cout << "File '" << current->filename << "' removed from position " << position << ".\n";
+        positions.erase(current);
+        destroyNode(current);
+        count--;
+    }
+
+    void removeFile(const string& filename) {
+        if (isEmpty()) {
+            cout << "List is empty.\n";
+            return;
+        }
+
+        FileNode* current = nameIndex.find(filename);
+        if (!current) {
+            cout << "File '" << filename << "' not found.\n";
+            return;
+        }
+
+        if (current == head) {
+            removeFileFromBeginning();
+            return;
+        }
+
+        if (current == tail) {
+            removeFileFromEnd();
+            return;
+        }
+
+        cout << "File '" << current->filename << "' removed.\n";
+        removeNode(current);
+    }
+
+    // Unlink and free a node without printing anything
+    void removeNode(FileNode* node) {
+        if (node->prev) {
+            node->prev->next = node->next;
+        } else {
+            head = node->next;
+        }
+        if (node->next) {
+            node->next->prev = node->prev;
+        } else {
+            tail = node->prev;
+        }
+        positions.erase(node);
+        destroyNode(node);
+        count--;
+    }
+
+    // Unlink and free many nodes at once without walking the list. A large
+    // share of the list is cheaper to drop from the position index by
+    // rebuilding it once than by erasing node by node.
+    void removeNodes(const vector<FileNode*>& nodes) {
+        if (nodes.size() <= static_cast<size_t>(count) / 8) {
+            for (FileNode* node : nodes) {
+                removeNode(node);
+            }
+            return;
+        }
+        for (FileNode* node : nodes) {
+            if (node->prev) {
+                node->prev->next = node->next;
+            } else {
+                head = node->next;
+            }
+            if (node->next) {
+                node->next->prev = node->prev;
+            } else {
+                tail = node->prev;
+            }
+            destroyNode(node);
+            count--;
+        }
+        positions.rebuild(head);
+    }
+
+    // Stable bottom-up merge sort that relinks nodes instead of swapping their data.
+    // less(a, b) must return true when a sorts strictly before b.
+    template <typename Less>
+    void sortBy(Less less) {
+        if (count <= 1) return;
+
+        FileNode* list = head;
+        for (int width = 1; width < count; width *= 2) {
+            FileNode* merged = nullptr;
+            FileNode** mergedTail = &merged;
+            FileNode* rest = list;
+
+            while (rest) {
+                FileNode* left = rest;
+                FileNode* right = splitAfter(left, width);
+                rest = splitAfter(right, width);
+                mergedTail = mergeRuns(left, right, mergedTail, less);
+            }
+            list = merged;
+        }
+
+        // Restore the back links and tail from the merged forward chain
+        FileNode* previous = nullptr;
+        for (FileNode* current = list; current; current = current->next) {
+            current->prev = previous;
+            previous = current;
+        }
+        head = list;
+        tail = previous;
+        positions.rebuild(head);
+    }
+
+    void sortByName() {
+        sortBy([](const FileNode& a, const FileNode& b) {
+            return a.filename < b.filename;
+        });
+    }
+
+    // Size and date order are already held by the ordered indexes, so these
+    // only relink the list in index order. Entries with equal keys keep their
+    // current relative order, as with the merge sort, so sorts compose.
+    void sortBySize() {
+        relinkInOrder(sizeIndex);
+    }
+
+    void sortByModifiedDate() {
+        relinkInOrder(modifiedIndex);
+    }
+
+    // Index keys are (key, id); ids only make them unique, so each run of
+    // equal keys is re-ordered by list position before relinking
+    template <typename Index>
+    void relinkInOrder(const Index& index) {
+        vector<FileNode*> order;
+        order.reserve(count);
+        vector<pair<int, FileNode*>> run;
+        auto flushRun = [&] {
+            if (run.size() > 1) {
+                for (auto& entry : run) entry.first = PositionIndex::indexOf(entry.second);
+                sort(run.begin(), run.end());
+            }
+            for (auto& entry : run) order.push_back(entry.second);
+            run.clear();
+        };
+        for (auto it = index.begin(); it != index.end(); ++it) {
+            if (!run.empty() && it->first.first != prev(it)->first.first) flushRun();
+            run.emplace_back(0, it->second);
+        }
+        flushRun();
+
+        FileNode* previous = nullptr;
+        head = nullptr;
+        for (FileNode* node : order) {
+            node->prev = previous;
+            if (previous) {
+                previous->next = node;
+            } else {
+                head = node;
+            }
+            previous = node;
+        }
+        if (previous) previous->next = nullptr;
+        tail = previous;
+        positions.rebuild(head);
+    }
+
+    map<FileType, size_t> getTotalSizesByType() const {
+        map<FileType, size_t> sizeMap;
+        FileNode* current = head;
+        while (current) {
+            sizeMap[current->type] += current->size;
+            current = current->next;
+        }
+        return sizeMap;
+    }
+
+    void printFiles() const {
+        if (isEmpty()) {
+            cout << "No files in the list.\n";
+            return;
+        }
+
+        FileNode* current = head;
+        int index = 1;
+        
+        while (current) {
+            cout << index++ << ". " << current->filename << endl;
+            cout << "------------------------------------------------------\n";
+            current->displayInfo();
+            current = current->next;
+            if (current) cout << endl;
+        }
+    }
+
+    // Nodes and names are released slab by slab rather than one at a time
+    void clear() {
+        nodePool.clear();
+        names.clear();
+        head = tail = nullptr;
+        count = 0;
+        positions.clear();
+        contentIndex.clear();
+        nameIndex.clear();
+        nameTree.clear();
+        contentCache.clear();
+        sizeIndex.clear();
+        modifiedIndex.clear();
+    }
+
+    FileNode* getFileNode(const string& filename) {
+        FileNode* current = nameIndex.find(filename);
+        if (current) {
+            current->lastSeenDate = time(nullptr);
+        }
+        return current;
+    }
+
+    const FileNode* getFileNode(const string& filename) const {
+        return nameIndex.find(filename);
+    }
+
+    FileNode* getFileNode(int index) {
+        if (index < 0 || index >= count) return nullptr;
+
+        FileNode* current = positions.at(index);
+        if (current) {
+            current->lastSeenDate = time(nullptr);
+        }
+        return current;
+    }
+
+    void addFile(const string& filename, int position = -1) {
+        if (position == -1) {
+            addFileAtEnd(filename);
+        } else if (position == 0) {
+            addFileAtBeginning(filename);
+        } else {
+            addFileAtPosition(filename, position);
+        }
+    }
+
+    void removeFile(int position = -1) {
+        if (position == -1) {
+            removeFileFromEnd();
+        } else if (position == 0) {
+            removeFileFromBeginning();
+        } else {
+            removeFileFromPosition(position);
+        }
+    }
+
+    // Matches are listed in name order
+    void searchByPrefix(const string& prefix) const {
+        int index = 1;
+        size_t found = nameTree.forEachWithPrefix(prefix, 0, [&](FileNode* current) {
+            cout << index++ << ". " << current->filename << endl;
+            current->displayInfo();
+            current->lastSeenDate = time(nullptr);
+        });
+        
+        if (found == 0) {
+            cout << "No files found with prefix '" << prefix << "'.\n";
+        }
+    }
+
+    // First few names starting with prefix, for interactive completion
+    vector<string> completeName(const string& prefix, size_t limit) const {
+        vector<string> names;
+        nameTree.forEachWithPrefix(prefix, limit, [&](FileNode* current) {
+            names.emplace_back(current->filename);
+        });
+        return names;
+    }
+
+    // Content of a managed file, served from the cache or mapped from disk on a miss
+    shared_ptr<const MappedFile> loadContent(FileNode* node) {
+        if (node->type == DIRECTORY) return make_shared<const MappedFile>();
+
+        shared_ptr<const MappedFile> content = contentCache.find(node->filename);
+        if (!content) {
+            content = contentCache.put(node->filename, MappedFile::open(node->filename));
+            node->lineCount = countLines(content->view());
+        }
+        return content;
+    }
+
+    // Drop any cached copy and read the file again from disk
+    shared_ptr<const MappedFile> reloadContent(FileNode* node) {
+        contentCache.erase(node->filename);
+        shared_ptr<const MappedFile> content = loadContent(node);
+        refreshFileStats(node, content->size());
+        indexContent(node);
+        return content;
+    }
+
+    // Record content just written to disk; the next read maps the new bytes.
+    // New content can change what the file is, so its type is sniffed again.
+    void updateFileContent(const string& filename, const string& content) {
+        FileNode* fileNode = getFileNode(filename);
+        if (fileNode) {
+            contentCache.erase(filename);
+            fileNode->lineCount = countLines(content);
+            fileNode->type = sniffFileType(reinterpret_cast<const unsigned char*>(content.data()),
+                                           min(content.size(), MagicMatcher::HEADER_BYTES),
+                                           getFileTypeFromExtension(filename));
+            refreshFileStats(fileNode, content.size());
+            if (contentIndexEnabled) {
+                contentIndex.addDocument(fileNode->id, filename, content, content.size(),
+                                         fileModifiedStamp(filename));
+            }
+        }
+    }
+
+    // Account for bytes appended on disk; the cached copy is now stale. The
+    // type is sniffed again only if the append reached into the header.
+    void appendFileContent(const string& filename, const string& appended) {
+        FileNode* fileNode = getFileNode(filename);
+        if (fileNode) {
+            contentCache.erase(filename);
+            fileNode->lineCount = -1;
+            if (fileNode->size < MagicMatcher::HEADER_BYTES) fileNode->type = detectFileType(filename);
+            refreshFileStats(fileNode, fileNode->size + appended.size());
+            indexContent(fileNode);
+        }
+    }
+
+    // (Re)index a file's current content if the keyword index is on
+    void indexContent(FileNode* node) {
+        if (!contentIndexEnabled || node->type == DIRECTORY) return;
+        shared_ptr<const MappedFile> content = loadContent(node);
+        contentIndex.addDocument(node->id, node->filename, content->view(), content->size(),
+                                 fileModifiedStamp(node->filename));
+    }
+
+    // Load the persisted keyword index, keeping entries whose file is unchanged
+    // on disk, then index whatever is missing or stale.
+    void buildContentIndex(const string& path) {
+        contentIndex.load(path, [this](const InvertedIndex::Document& document, size_t& id) {
+            FileNode* node = nameIndex.find(document.filename);
+            if (!node || node->type == DIRECTORY) return false;
+            if (document.size != fileSizeOnDisk(document.filename) ||
+                document.modified != fileModifiedStamp(document.filename)) {
+                return false;
+            }
+            id = node->id;
+            return true;
+        });
+        for (FileNode* current = head; current; current = current->next) {
+            if (current->type != DIRECTORY && !contentIndex.contains(current->id)) {
+                indexContent(current);
+            }
+        }
+    }
+
+    vector<ContentMatch> searchByKeywords(const string& query) {
+        vector<ContentMatch> results;
+        for (const auto& hit : contentIndex.query(query)) {
+            auto document = contentIndex.documents.find(hit.first);
+            FileNode* node = nameIndex.find(document->second.filename);
+            if (node) {
+                node->lastSeenDate = time(nullptr);
+                results.push_back({node, hit.second, {}});
+            }
+        }
+        sort(results.begin(), results.end(), [](const ContentMatch& a, const ContentMatch& b) {
+            return a.node->filename < b.node->filename;
+        });
+        return results;
+    }
+
+    void sortFiles(int criteria) {
+        switch (criteria) {
+            case 1: sortByName(); break;
+            case 2: sortBySize(); break;
+            case 3: sortByModifiedDate(); break;
+            default: cout << "Invalid sorting criteria.\n";
+        }
+    }
+
+    void setSearchOptions(const SearchOptions& options) {
+        if (options.threads != searchOptions.threads) searchPool.reset();
+        searchOptions = options;
+        if (searchOptions.chunkSize == 0) searchOptions.chunkSize = 1;
+    }
+
+    // Files are split into chunks that run on the search pool; results are
+    // merged back in list order.
+    vector<ContentMatch> searchByContent(const string& keyword) {
+        vector<FileNode*> files;
+        for (FileNode* current = head; current; current = current->next) {
+            if (current->type != DIRECTORY) files.push_back(current);
+        }
+
+        size_t chunkSize = searchOptions.chunkSize;
+        size_t chunkCount = (files.size() + chunkSize - 1) / chunkSize;
+        vector<vector<ContentMatch>> partial(chunkCount);
+
+        auto searchChunk = [&](size_t chunk) {
+            SearchKernel search = activeSearchKernel();
+            size_t end = min(files.size(), (chunk + 1) * chunkSize);
+            for (size_t i = chunk * chunkSize; i < end; i++) {
+                ContentMatch match{files[i], 0, {}};
+                match.matchCount = search(loadContent(files[i])->view(), keyword,
+                                          &match.offsets, ContentMatch::MAX_OFFSETS);
+                if (match.matchCount > 0) {
+                    files[i]->lastSeenDate = time(nullptr);
+                    partial[chunk].push_back(move(match));
+                }
+            }
+        };
+
+        if (chunkCount <= 1 || searchOptions.threads == 1) {
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) searchChunk(chunk);
+        } else {
+            if (!searchPool) searchPool = make_unique<ThreadPool>(searchOptions.threads);
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+                searchPool->submit([&searchChunk, chunk] { searchChunk(chunk); });
+            }
+            searchPool->wait();
+        }
+
+        vector<ContentMatch> results;
+        for (vector<ContentMatch>& chunkResults : partial) {
+            for (ContentMatch& match : chunkResults) results.push_back(move(match));
+        }
+        return results;
+    }
+
+    // Reclassify every file from its extension and first bytes. Header reads
+    // run on the search pool a chunk at a time; the new types are applied on
+    // this thread afterwards. Returns how many entries changed type.
+    size_t detectContentTypes() {
+        vector<FileNode*> files;
+        for (FileNode* current = head; current; current = current->next) {
+            if (current->type != DIRECTORY) files.push_back(current);
+        }
+
+        vector<FileType> detected(files.size());
+        size_t chunkSize = searchOptions.chunkSize;
+        size_t chunkCount = (files.size() + chunkSize - 1) / chunkSize;
+        auto detectChunk = [&](size_t chunk) {
+            size_t end = min(files.size(), (chunk + 1) * chunkSize);
+            for (size_t i = chunk * chunkSize; i < end; i++) {
+                detected[i] = detectFileType(files[i]->filename);
+            }
+        };
+
+        if (chunkCount <= 1 || searchOptions.threads == 1) {
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) detectChunk(chunk);
+        } else {
+            if (!searchPool) searchPool = make_unique<ThreadPool>(searchOptions.threads);
+            for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+                searchPool->submit([&detectChunk, chunk] { detectChunk(chunk); });
+            }
+            searchPool->wait();
+        }
+
+        size_t changed = 0;
+        for (size_t i = 0; i < files.size(); i++) {
+            if (files[i]->type != detected[i]) {
+                files[i]->type = detected[i];
+                changed++;
+            }
+        }
+        return changed;
+    }
+
+    vector<FileNode*> searchByType(FileType type) {
+        vector<FileNode*> results;
+        FileNode* current = head;
+        while (current) {
+            if (current->type == type) {
+                results.push_back(current);
+                current->lastSeenDate = time(nullptr);
+            }
+            current = current->next;
+        }
+        return results;
+    }
+
+    // Results come back in ascending size order
+    vector<FileNode*> searchBySizeRange(size_t minSize, size_t maxSize) {
+        vector<FileNode*> results;
+        auto it = sizeIndex.lower_bound(make_pair(minSize, size_t(0)));
+        auto end = sizeIndex.upper_bound(make_pair(maxSize, numeric_limits<size_t>::max()));
+        for (; it != end; ++it) {
+            FileNode* current = it->second;
+            if (current->type != DIRECTORY) {
+                results.push_back(current);
+                current->lastSeenDate = time(nullptr);
+            }
+        }
+        return results;
+    }
+
+    // Results come back in ascending modification time order
+    vector<FileNode*> searchByModifiedRange(time_t from, time_t to) {
+        vector<FileNode*> results;
+        auto it = modifiedIndex.lower_bound(make_pair(from, size_t(0)));
+        auto end = modifiedIndex.upper_bound(make_pair(to, numeric_limits<size_t>::max()));
+        for (; it != end; ++it) {
+            results.push_back(it->second);
+            it->second->lastSeenDate = time(nullptr);
+        }
+        return results;
+    }
+};
+// Same output as formatTime without a localtime() call per timestamp. The UTC
+// offset is looked up once per hour of timestamps and the calendar date is
+// computed arithmetically. A DST change that is not on a UTC hour boundary
+// can put a timestamp in that hour off by the change.
+struct TimeFormatter {
+    long long cachedHour;
+    long cachedOffset;
+
+    TimeFormatter() : cachedHour(numeric_limits<long long>::min()), cachedOffset(0) {}
+
+    void append(OutputBuffer& out, time_t time) {
+#if defined(__unix__) || defined(__APPLE__)
+        if (time == 0) {
+            out.append("Unknown");
+            return;
+        }
+        long long hour = static_cast<long long>(time) / 3600;
+        if (hour != cachedHour) {
+            tm local;
+            localtime_r(&time, &local);
+            cachedHour = hour;
+            cachedOffset = local.tm_gmtoff;
+        }
+        long long seconds = static_cast<long long>(time) + cachedOffset;
+        long long days = seconds / 86400 - (seconds % 86400 < 0 ? 1 : 0);
+        long long secondOfDay = seconds - days * 86400;
+
+        // Civil date from days since 1970-01-01 (proleptic Gregorian)
+        long long z = days + 719468;
+        long long era = (z >= 0 ? z : z - 146096) / 146097;
+        long long dayOfEra = z - era * 146097;
+        long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        long long monthIndex = (5 * dayOfYear + 2) / 153;
+        long long day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        long long month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        long long year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+        char text[96];
+        snprintf(text, sizeof(text), "%04lld-%02lld-%02lld %02lld:%02lld:%02lld", year, month, day,
+                 secondOfDay / 3600, secondOfDay / 60 % 60, secondOfDay % 60);
+        out.append(text);
+#else
+        out.append(formatTime(time));
+#endif
+    }
+};
+
+struct ListingOptions {
+    enum SortKey { UNSORTED, BY_NAME, BY_SIZE, BY_MODIFIED };
+
+    SortKey sortKey;
+    bool descending;
+    size_t limit;    // Show only the first N entries; 0 = all
+    size_t pageSize; // Pause after this many entries; 0 = no paging
+    bool details;    // Size and modification time, which cost a stat each
+
+    ListingOptions() : sortKey(UNSORTED), descending(false), limit(0), pageSize(0), details(true) {}
+};
+
+// Directory listing engine. On Linux entries come from DirentReader;
+// d_type gives the type of most entries for free, so an entry is only
+// stat'ed (statx, relative to the open directory) when the listing shows
+// details, sorts by a stat field, or the filesystem did not report its
+// type. Stats run in chunks on a thread pool. Unsorted listings stream:
+// the directory is read, stat'ed and printed a batch at a time, and a
+// "first N" listing stops reading after N entries. Sorted listings read
+// every name, but stat only what the sort needs plus the entries shown.
+struct DirectoryLister {
+    static constexpr size_t BATCH_ENTRIES = 4096; // Entries per streamed batch
+    static constexpr size_t STAT_CHUNK = 256;     // Entries per thread pool task
+
+    struct Entry {
+        uint32_t nameOffset; // Into names; each name is NUL-terminated there
+        uint32_t nameLength;
+        FileType type;
+        bool typeKnown;
+        bool statted;
+        uint64_t size;
+        time_t modified;
+    };
+
+    string path;
+    ListingOptions options;
+    string names;
+    vector<Entry> entries;
+    unique_ptr<ThreadPool> pool; // Created when a batch is worth splitting
+    size_t listed;
+    size_t statCalls;
+    bool exhausted;
+    TimeFormatter timeFormatter;
+#ifdef __linux__
+    DirentReader reader;
+#else
+    fs::directory_iterator iterator;
+#endif
+
+    DirectoryLister(const string& directory, const ListingOptions& listingOptions) :
+        path(directory), options(listingOptions), listed(0), statCalls(0), exhausted(false) {}
+
+    // Prints the listing; throws fs::filesystem_error if the directory cannot be read
+    void run(OutputBuffer& out) {
+        openDirectory();
+        if (options.sortKey == ListingOptions::UNSORTED) {
+            while (!exhausted && !limitReached()) {
+                size_t wanted = options.limit ? min(BATCH_ENTRIES, options.limit - listed) : BATCH_ENTRIES;
+                entries.clear();
+                names.clear();
+                readEntries(wanted);
+                statEntries(0, entries.size(), options.details);
+                if (!printEntries(out, 0, entries.size())) return;
+            }
+            return;
+        }
+
+        while (!exhausted) readEntries(numeric_limits<size_t>::max());
+        bool sortNeedsStats = options.sortKey != ListingOptions::BY_NAME;
+        if (sortNeedsStats) statEntries(0, entries.size(), true);
+
+        size_t shown = options.limit ? min(options.limit, entries.size()) : entries.size();
+        auto less = [this](const Entry& a, const Entry& b) {
+            if (options.sortKey == ListingOptions::BY_SIZE && a.size != b.size) return a.size < b.size;
+            if (options.sortKey == ListingOptions::BY_MODIFIED && a.modified != b.modified) {
+                return a.modified < b.modified;
+            }
+            return nameOf(a) < nameOf(b);
+        };
+        auto ordered = [&](const Entry& a, const Entry& b) {
+            return options.descending ? less(b, a) : less(a, b);
+        };
+        if (shown < entries.size()) {
+            partial_sort(entries.begin(), entries.begin() + shown, entries.end(), ordered);
+        } else {
+            sort(entries.begin(), entries.end(), ordered);
+        }
+
+        statEntries(0, shown, options.details);
+        printEntries(out, 0, shown);
+    }
+
+    string_view nameOf(const Entry& entry) const {
+        return string_view(names.data() + entry.nameOffset, entry.nameLength);
+    }
+
+private:
+    bool limitReached() const {
+        return options.limit != 0 && listed >= options.limit;
+    }
+
+    void addEntry(string_view name, FileType type, bool typeKnown) {
+        Entry entry{static_cast<uint32_t>(names.size()), static_cast<uint32_t>(name.size()),
+                    type, typeKnown, false, 0, 0};
+        names.append(name.data(), name.size());
+        names.push_back('\0');
+        entries.push_back(entry);
+    }
+
+#ifdef __linux__
+    void openDirectory() {
+        if (!reader.open(path)) {
+            throw fs::filesystem_error("cannot open directory", fs::path(path), error_code(errno, generic_category()));
+        }
+    }
+
+    // Append up to wanted entries
+    void readEntries(size_t wanted) {
+        string_view name;
+        unsigned char type;
+        for (size_t added = 0; added < wanted; added++) {
+            if (!reader.next(name, type)) {
+                if (errno != 0) {
+                    throw fs::filesystem_error("cannot read directory", fs::path(path), error_code(errno, generic_category()));
+                }
+                exhausted = true;
+                return;
+            }
+
+            if (type == DT_DIR) {
+                addEntry(name, DIRECTORY, true);
+            } else if (type == DT_REG) {
+                addEntry(name, getFileTypeFromExtension(name), true);
+            } else {
+                addEntry(name, OTHER, false); // Symlink or unknown: the stat decides
+            }
+        }
+    }
+
+    void statEntry(Entry& entry) const {
+        struct statx info;
+        const char* name = names.data() + entry.nameOffset;
+        if (statx(reader.fd, name, AT_NO_AUTOMOUNT, STATX_TYPE | STATX_SIZE | STATX_MTIME, &info) != 0) return;
+        bool isDirectory = S_ISDIR(info.stx_mode);
+        entry.type = isDirectory ? DIRECTORY : getFileTypeFromExtension(nameOf(entry));
+        entry.typeKnown = true;
+        entry.size = S_ISREG(info.stx_mode) ? info.stx_size : 0;
+        entry.modified = static_cast<time_t>(info.stx_mtime.tv_sec);
+    }
+#else
+    void openDirectory() {
+        iterator = fs::directory_iterator(path);
+    }
+
+    void readEntries(size_t wanted) {
+        for (size_t added = 0; added < wanted; added++) {
+            if (iterator == fs::directory_iterator()) {
+                exhausted = true;
+                return;
+            }
+            string name = iterator->path().filename().string();
+            addEntry(name, getFileType(*iterator), true);
+            ++iterator;
         }
-        count++;
     }
 
-    void addFileAtPosition(const string& filename, int position, const string& content) {
-        if (position < 0 || position > count) {
-            cout << "Invalid position.\n";
-            return;
+    void statEntry(Entry& entry) const {
+        error_code ec;
+        fs::path entryPath = fs::path(path) / string(nameOf(entry));
+        fs::file_status status = fs::status(entryPath, ec);
+        if (ec) return;
+        entry.type = getFileType(nameOf(entry), status);
+        entry.typeKnown = true;
+        entry.size = fs::is_regular_file(status) ? fs::file_size(entryPath, ec) : 0;
+        if (ec) entry.size = 0;
+        auto stamp = fs::last_write_time(entryPath, ec);
+        if (!ec) {
+            entry.modified = chrono::system_clock::to_time_t(
+                chrono::time_point_cast<chrono::system_clock::duration>(
+                    stamp - decltype(stamp)::clock::now() + chrono::system_clock::now()));
         }
-
-        if (position == 0) {
-            addFileAtBeginning(filename, content);
-            return;
+    }
+#endif
+
+    // Stat entries in [begin, end) that need it; all of them when details are
+    // wanted, otherwise only those whose type is still unknown
+    void statEntries(size_t begin, size_t end, bool details) {
+        vector<size_t> pending;
+        for (size_t i = begin; i < end; i++) {
+            if (!entries[i].statted && (details || !entries[i].typeKnown)) pending.push_back(i);
         }
+        statCalls += pending.size();
 
-        if (position == count) {
-            addFileAtEnd(filename, content);
+        auto statChunk = [this, &pending](size_t chunk) {
+            size_t stop = min(pending.size(), (chunk + 1) * STAT_CHUNK);
+            for (size_t i = chunk * STAT_CHUNK; i < stop; i++) {
+                statEntry(entries[pending[i]]);
+                entries[pending[i]].statted = true;
+            }
+        };
+        size_t chunkCount = (pending.size() + STAT_CHUNK - 1) / STAT_CHUNK;
+        if (chunkCount <= 1) {
+            if (chunkCount == 1) statChunk(0);
             return;
         }
-
-        FileNode* newNode = new FileNode(filename, content);
-        FileNode* current = head;
-        for (int i = 0; i < position - 1; i++) {
-            current = current->next;
+        if (!pool) pool = make_unique<ThreadPool>();
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            pool->submit([&statChunk, chunk] { statChunk(chunk); });
         }
-    
-        newNode->next = current->next;
-        newNode->prev = current;
-        current->next->prev = newNode;
-        current->next = newNode;
-        count++;
+        pool->wait();
     }
 
-void removeFileFromBeginning() {
-        if (isEmpty()) {
-            cout << "List is empty.\n";
-            return;
-        }
+    // Returns false if the user stopped at a page prompt
+    bool printEntries(OutputBuffer& out, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const Entry& entry = entries[i];
+            out.appendNumber(++listed);
+            out.append(". ");
+            out.append(nameOf(entry));
+            out.append(" (");
+            out.append(fileTypeToString(entry.type));
+            out.append(")\n");
+            if (options.details) {
+                if (entry.type != DIRECTORY) {
+                    out.append("   Size: ");
+                    out.appendNumber(entry.size);
+                    out.append(" bytes\n");
+                }
+                out.append("   Modified: ");
+                timeFormatter.append(out, entry.modified);
+                out.append('\n');
+            }
 
-        FileNode* temp = head;
-        if (head == tail) {
-            head = tail = nullptr;
-        } else {
-            head = head->next;
-            head->prev = nullptr;
+            bool moreToShow = i + 1 < end || (!exhausted && !limitReached());
+            if (options.pageSize != 0 && listed % options.pageSize == 0 && moreToShow) {
+                out.append("-- Press Enter for more, q to stop --");
+                out.flush();
+                string reply;
+                getline(cin, reply);
+                if (!reply.empty() && (reply[0] == 'q' || reply[0] == 'Q')) return false;
+            }
         }
-        
-        cout << "File '" << temp->filename << "' removed from beginning.\n";
-        delete temp;
-        count--;
+        return true;
     }
+};
 
-    void removeFileFromEnd() {
-        if (isEmpty()) {
-            cout << "List is empty.\n";
-            return;
-        }
+// Binary catalog snapshot plus a write-ahead journal of the edits made since.
+// Startup reads the snapshot and replays the journal, with no per-file stat
+// calls; a single edit costs one small, fsync'ed journal append. The journal
+// is folded into a fresh snapshot once it outgrows the snapshot.
+//
+// Snapshots are replaced atomically and carry a generation number; the
+// journal names the generation it applies to, so a journal left over from
+// before the latest snapshot is never replayed twice. Journal records are
+// CRC-framed. Operations with filesystem side effects are bracketed by
+// BEGIN/COMMIT (or ABORT) so recover() can resolve one cut short by a crash.
+struct CatalogStore {
+    static constexpr const char* SNAPSHOT_MAGIC = "FMCAT2";
+    static constexpr const char* JOURNAL_MAGIC = "FMJNL2";
+    static constexpr size_t MIN_COMPACTION_ENTRIES = 1024;
+    static constexpr size_t SNAPSHOT_PARSE_CHUNK = 16384; // Entries decoded per task
+
+    enum JournalOp : char {
+        OP_ADD = 'A', OP_REMOVE = 'R', OP_UPDATE = 'U', OP_RENAME = 'N',
+        OP_BEGIN = 'B', OP_COMMIT = 'C', OP_ABORT = 'X'
+    };
+
+    struct RecoveryReport {
+        size_t records = 0;
+        size_t truncatedBytes = 0;
+        bool staleJournal = false;
+        bool rolledForward = false;
+        bool rolledBack = false;
+    };
+
+    string snapshotPath;
+    string journalPath;
+    uint64_t generation;
+    size_t snapshotEntries;
+    size_t journalEntries;
+    bool inTransaction;
+    bool intentLogged; // BEGIN and the records so far are on disk
+    bool snapshotWritable; // False while an unreadable snapshot could not be moved aside
+    vector<string> transaction; // Records of the open operation not yet written
+#ifndef _WIN32
+    int journalFd;
+#else
+    ofstream journal;
+#endif
+
+    CatalogStore() : snapshotPath("catalog.bin"), journalPath("catalog.journal"), generation(0),
+                     snapshotEntries(0), journalEntries(0), inTransaction(false),
+                     intentLogged(false), snapshotWritable(true) {
+#ifndef _WIN32
+        journalFd = -1;
+#endif
+    }
 
-        FileNode* temp = tail;
-        if (head == tail) {
-            head = tail = nullptr;
-        } else {
-            tail = tail->prev;
-            tail->next = nullptr;
-        }
-        
-        cout << "File '" << temp->filename << "' removed from end.\n";
-        delete temp;
-        count--;
+    ~CatalogStore() {
+        closeJournal();
     }
 
-    void removeFileFromPosition(int position) {
-        if (position < 0 || position >= count) {
-            cout << "Invalid position.\n";
-            return;
-        }
+    bool exists() const {
+        return fs::exists(snapshotPath);
+    }
 
-        if (position == 0) {
-            removeFileFromBeginning();
-            return;
-        }
+    bool needsCompaction() const {
+        return snapshotWritable && !inTransaction && journalEntries >= max(MIN_COMPACTION_ENTRIES, snapshotEntries);
+    }
 
-        if (position == count - 1) {
-            removeFileFromEnd();
-            return;
+    // Move a snapshot that cannot be read, and the journal written against
+    // it, to "<name>.corrupt" (numbered if that is taken) so the next save
+    // starts a new catalog instead of overwriting them. Returns the new
+    // snapshot name; if the move fails, snapshots stay disabled and "" is
+    // returned.
+    string setAsideCorrupt() {
+        closeJournal();
+        string suffix = ".corrupt";
+        for (int i = 1; fs::exists(snapshotPath + suffix) || fs::exists(journalPath + suffix); i++) {
+            suffix = ".corrupt." + to_string(i);
         }
-
-        FileNode* current = head;
-        for (int i = 0; i < position; i++) {
-            current = current->next;
+        error_code ec;
+        fs::rename(snapshotPath, snapshotPath + suffix, ec);
+        if (ec) {
+            snapshotWritable = false;
+            return "";
         }
-        
-        current->prev->next = current->next;
-        current->next->prev = current->prev;
-        
-        cout << "File '" << current->filename << "' removed from position " << position << ".\n";
-        delete current;
-        count--;
+        if (fs::exists(journalPath)) fs::rename(journalPath, journalPath + suffix, ec);
+        generation = 0;
+        snapshotEntries = 0;
+        journalEntries = 0;
+        return snapshotPath + suffix;
     }
 
-    void removeFile(const string& filename) {
-        if (isEmpty()) {
-            cout << "List is empty.\n";
-            return;
+    // Snapshot layout: magic, generation, entry count, then per entry the name,
+    // size, created and modified times and type, all varint encoded.
+    bool writeSnapshot(const FileList& list) {
+        if (!snapshotWritable) return false;
+        string out(SNAPSHOT_MAGIC);
+        writeVarint(out, generation + 1);
+        writeVarint(out, list.size());
+        for (const FileNode* current = list.head; current; current = current->next) {
+            writeBytes(out, current->filename);
+            writeVarint(out, current->size);
+            writeVarint(out, static_cast<uint64_t>(current->createdDate));
+            writeVarint(out, static_cast<uint64_t>(current->lastModified));
+            writeVarint(out, current->type);
         }
+        if (!writeFileAtomically(snapshotPath, out)) return false;
+
+        // Everything in the journal is now part of the snapshot. If the
+        // journal removal is lost to a crash, its generation no longer
+        // matches and it is discarded at the next start.
+        generation++;
+        closeJournal();
+        error_code ec;
+        fs::remove(journalPath, ec);
+        snapshotEntries = list.size();
+        journalEntries = 0;
+        return true;
+    }
 
-        if (head->filename == filename) {
-            removeFileFromBeginning();
-            return;
+    // Entry boundaries come from a serial pass that skips over the fields
+    // without decoding names; the entries between them are then decoded a
+    // chunk at a time, on the pool when one is given.
+    bool readSnapshot(vector<CatalogRecord>& records, ThreadPool* pool = nullptr) {
+        shared_ptr<const MappedFile> snapshot = MappedFile::open(snapshotPath);
+        string_view data = snapshot->view();
+        const char* cursor = data.data();
+        const char* end = data.data() + data.size();
+        uint64_t entryCount;
+        if (!readSnapshotHeader(cursor, end, generation) || !readVarint(cursor, end, entryCount)) {
+            return false;
         }
 
-        if (tail->filename == filename) {
-            removeFileFromEnd();
-            return;
+        vector<const char*> chunkStarts;
+        for (uint64_t i = 0; i < entryCount; i++) {
+            if (i % SNAPSHOT_PARSE_CHUNK == 0) chunkStarts.push_back(cursor);
+            if (!skipSnapshotEntry(cursor, end)) return false;
         }
 
-        FileNode* current = head->next;
-        while (current && current->filename != filename) {
-            current = current->next;
-        }
+        records.assign(entryCount, CatalogRecord());
+        atomic<bool> valid(true);
+        auto decodeChunk = [&](size_t chunk) {
+            const char* at = chunkStarts[chunk];
+            size_t last = min<size_t>(entryCount, (chunk + 1) * SNAPSHOT_PARSE_CHUNK);
+            for (size_t i = chunk * SNAPSHOT_PARSE_CHUNK; i < last; i++) {
+                CatalogRecord& record = records[i];
+                uint64_t size, created, modified, type;
+                if (!readBytes(at, end, record.filename) || !readVarint(at, end, size) ||
+                    !readVarint(at, end, created) || !readVarint(at, end, modified) ||
+                    !readVarint(at, end, type) || type > OTHER) {
+                    valid = false;
+                    return;
+                }
+                record.type = static_cast<FileType>(type);
+                record.size = size;
+                record.created = static_cast<time_t>(created);
+                record.modified = static_cast<time_t>(modified);
+            }
+        };
 
-        if (current) {
-            current->prev->next = current->next;
-            if (current->next) {
-                current->next->prev = current->prev;
+        if (pool && chunkStarts.size() > 1) {
+            for (size_t chunk = 0; chunk < chunkStarts.size(); chunk++) {
+                pool->submit([&decodeChunk, chunk] { decodeChunk(chunk); });
             }
-            cout << "File '" << current->filename << "' removed.\n";
-            delete current;
-            count--;
+            pool->wait();
         } else {
-            cout << "File '" << filename << "' not found.\n";
+            for (size_t chunk = 0; chunk < chunkStarts.size(); chunk++) decodeChunk(chunk);
         }
+        if (!valid) return false;
+        snapshotEntries = records.size();
+        return true;
     }
 
-    void sortByName() {
-        if (count <= 1) return;
+    // Validate the journal before it is replayed: drop a journal that belongs
+    // to an older snapshot, cut off a torn or corrupt tail, and settle an
+    // operation that was still in flight. Cost is linear in the journal size.
+    RecoveryReport recover() {
+        RecoveryReport report;
+        error_code ec;
+        fs::remove(snapshotPath + ".tmp", ec);
+
+        // A snapshot whose header cannot be read is set aside by loadFiles
+        // together with its journal; the journal is not judged against it
+        shared_ptr<const MappedFile> snapshot = MappedFile::open(snapshotPath);
+        const char* cursor = snapshot->data;
+        if (!readSnapshotHeader(cursor, cursor + snapshot->size(), generation) && exists()) return report;
+
+        shared_ptr<const MappedFile> file = MappedFile::open(journalPath);
+        if (file->empty()) return report;
+
+        string_view data = file->view();
+        size_t bodyStart = 0;
+        uint64_t journalGeneration = 0;
+        if (!readJournalHeader(data, bodyStart, journalGeneration) || journalGeneration != generation) {
+            file.reset();
+            fs::remove(journalPath, ec);
+            report.staleJournal = true;
+            return report;
+        }
 
-        bool swapped;
-        FileNode* last = nullptr;
-        
-        do {
-            swapped = false;
-            FileNode* current = head;
-            
-            while (current->next != last) {
-                if (current->filename > current->next->filename) {
-                    swapNodesData(current, current->next);
-                    swapped = true;
-                }
-                current = current->next;
+        vector<pair<char, string_view>> pending; // Records of an unfinished operation
+        bool open = false;
+        size_t validEnd = scanFramedRecords(data, bodyStart, [&](char op, string_view payload) {
+            report.records++;
+            if (op == OP_BEGIN) {
+                open = true;
+                pending.clear();
+            } else if (op == OP_COMMIT || op == OP_ABORT) {
+                open = false;
+                pending.clear();
+            } else if (open) {
+                pending.push_back({op, payload});
+            }
+        });
+
+        // Keep the records whose effect the filesystem already shows. Nothing
+        // on disk is undone: a rolled back record only leaves the catalog.
+        vector<string> visible;
+        for (const auto& record : pending) {
+            if (effectVisible(record.first, record.second)) {
+                visible.push_back(string(1, record.first) + string(record.second));
+            }
+        }
+        bool partial = !visible.empty() && visible.size() < pending.size();
+        file.reset();
+
+        report.truncatedBytes = data.size() - validEnd;
+        if (report.truncatedBytes > 0) {
+            fs::resize_file(journalPath, validEnd, ec);
+        }
+        if (open) {
+            if (partial) {
+                // A new BEGIN supersedes the open group, so the visible
+                // records are committed on their own in one write
+                visible.insert(visible.begin(), string(1, OP_BEGIN));
+                visible.emplace_back(1, OP_COMMIT);
+                appendRecords(visible);
+            } else {
+                appendRecord(string(1, visible.empty() ? OP_ABORT : OP_COMMIT));
             }
-            last = current;
-        } while (swapped);
+            report.rolledForward = !visible.empty();
+            report.rolledBack = visible.empty();
+        }
+        return report;
     }
 
-    void sortBySize() {
-        if (count <= 1) return;
+    // Bracket the records of one operation; they take effect only once
+    // committed. BEGIN and the records are buffered until prepare() writes
+    // and syncs them, which the caller does before touching the filesystem,
+    // so a crash at any later point finds the intent on disk.
+    //
+    // Rolling back only drops records: the journal describes the catalog,
+    // and no filesystem change is ever undone. An operation whose filesystem
+    // step partly happened commits just the records for the part that did.
+    // A BEGIN while an operation is open supersedes it, since replay and
+    // recovery drop any group that never committed.
+    void begin() {
+        transaction.assign(1, string(1, OP_BEGIN));
+        intentLogged = false;
+        inTransaction = true;
+    }
 
-        bool swapped;
-        FileNode* last = nullptr;
-        
-        do {
-            swapped = false;
-            FileNode* current = head;
-            
-            while (current->next != last) {
-                if (current->size > current->next->size) {
-                    swapNodesData(current, current->next);
-                    swapped = true;
-                }
-                current = current->next;
-            }
-            last = current;
-        } while (swapped);
+    void prepare() {
+        appendRecords(transaction);
+        transaction.clear();
+        intentLogged = true;
     }
 
-    void sortByModifiedDate() {
-        if (count <= 1) return;
+    void commit() {
+        inTransaction = false;
+        transaction.emplace_back(1, OP_COMMIT);
+        appendRecords(transaction);
+        transaction.clear();
+    }
 
-        bool swapped;
-        FileNode* last = nullptr;
-        
-        do {
-            swapped = false;
-            FileNode* current = head;
-            
-            while (current->next != last) {
-                if (current->lastModified > current->next->lastModified) {
-                    swapNodesData(current, current->next);
-                    swapped = true;
-                }
-                current = current->next;
-            }
-            last = current;
-        } while (swapped);
+    void abort() {
+        inTransaction = false;
+        transaction.clear();
+        if (intentLogged) appendRecord(string(1, OP_ABORT));
     }
 
-    map<FileType, size_t> getTotalSizesByType() const {
-        map<FileType, size_t> sizeMap;
-        FileNode* current = head;
-        while (current) {
-            sizeMap[current->type] += current->size;
-            current = current->next;
-        }
-        return sizeMap;
+    void recordAdd(const FileNode& node, int position) {
+        string record(1, OP_ADD);
+        writeBytes(record, node.filename);
+        writeVarint(record, static_cast<uint64_t>(position));
+        writeVarint(record, node.size);
+        writeVarint(record, static_cast<uint64_t>(node.createdDate));
+        writeVarint(record, static_cast<uint64_t>(node.lastModified));
+        writeVarint(record, node.type);
+        append(record);
     }
 
-    void printFiles() const {
-        if (isEmpty()) {
-            cout << "No files in the list.\n";
-            return;
-        }
+    void recordRemove(const string& filename) {
+        string record(1, OP_REMOVE);
+        writeBytes(record, filename);
+        append(record);
+    }
 
-        FileNode* current = head;
-        int index = 1;
-        
-        while (current) {
-            cout << index++ << ". " << current->filename << endl;
-            cout << "------------------------------------------------------\n";
-            current->displayInfo();
-            current = current->next;
-            if (current) cout << endl;
-        }
+    void recordUpdate(const FileNode& node) {
+        string record(1, OP_UPDATE);
+        writeBytes(record, node.filename);
+        writeVarint(record, node.size);
+        writeVarint(record, static_cast<uint64_t>(node.lastModified));
+        writeVarint(record, node.type);
+        append(record);
     }
 
-    void clear() {
-        while (head) {
-            FileNode* temp = head;
-            head = head->next;
-            delete temp;
-        }
-        head = tail = nullptr;
-        count = 0;
+    void recordRename(const string& oldName, const string& newName, FileType type) {
+        string record(1, OP_RENAME);
+        writeBytes(record, oldName);
+        writeBytes(record, newName);
+        writeVarint(record, type);
+        append(record);
     }
 
-    FileNode* getFileNode(const string& filename) {
-        FileNode* current = head;
-        while (current) {
-            if (current->filename == filename) {
-                current->lastSeenDate = time(nullptr);
-                return current;
-            }
-            current = current->next;
+private:
+    bool readSnapshotHeader(const char*& cursor, const char* end, uint64_t& snapshotGeneration) const {
+        size_t magicLength = strlen(SNAPSHOT_MAGIC);
+        if (static_cast<size_t>(end - cursor) < magicLength ||
+            string_view(cursor, magicLength) != SNAPSHOT_MAGIC) {
+            return false;
         }
-        return nullptr;
+        cursor += magicLength;
+        return readVarint(cursor, end, snapshotGeneration);
     }
 
-    const FileNode* getFileNode(const string& filename) const {
-        FileNode* current = head;
-        while (current) {
-            if (current->filename == filename) {
-                return current;
-            }
-            current = current->next;
+    static bool skipSnapshotEntry(const char*& cursor, const char* end) {
+        uint64_t length, value;
+        if (!readVarint(cursor, end, length) || length > static_cast<uint64_t>(end - cursor)) {
+            return false;
         }
-        return nullptr;
+        cursor += length;
+        for (int field = 0; field < 4; field++) {
+            if (!readVarint(cursor, end, value)) return false;
+        }
+        return true;
     }
 
-    FileNode* getFileNode(int index) {
-        if (index < 0 || index >= count) return nullptr;
+    static bool readJournalHeader(string_view data, size_t& bodyStart, uint64_t& journalGeneration) {
+        size_t magicLength = strlen(JOURNAL_MAGIC);
+        if (data.substr(0, magicLength) != JOURNAL_MAGIC) return false;
+        const char* cursor = data.data() + magicLength;
+        if (!readVarint(cursor, data.data() + data.size(), journalGeneration)) return false;
+        bodyStart = cursor - data.data();
+        return true;
+    }
 
-        FileNode* current = head;
-        for (int i = 0; i < index && current; i++) {
-            current = current->next;
-        }
-        if (current) {
-            current->lastSeenDate = time(nullptr);
+    // Whether the filesystem already shows the effect of an in-flight record
+    static bool effectVisible(char op, string_view payload) {
+        const char* cursor = payload.data();
+        const char* end = payload.data() + payload.size();
+        string filename, newName;
+        if (!readBytes(cursor, end, filename)) return false;
+
+        error_code ec;
+        switch (op) {
+            case OP_REMOVE:
+                return !fs::exists(filename, ec);
+            case OP_RENAME:
+                return readBytes(cursor, end, newName) &&
+                       fs::exists(newName, ec) && !fs::exists(filename, ec);
+            case OP_ADD:
+                return fs::exists(filename, ec);
+            default:
+                return true; // Metadata only
         }
-        return current;
     }
 
-    void addFile(const string& filename, const string& content = "", int position = -1) {
-        if (position == -1) {
-            addFileAtEnd(filename, content);
-        } else if (position == 0) {
-            addFileAtBeginning(filename, content);
+    void append(const string& record) {
+        if (inTransaction) {
+            transaction.push_back(record);
         } else {
-            addFileAtPosition(filename, position, content);
+            appendRecord(record);
         }
     }
 
-    void removeFile(int position = -1) {
-        if (position == -1) {
-            removeFileFromEnd();
-        } else if (position == 0) {
-            removeFileFromBeginning();
-        } else {
-            removeFileFromPosition(position);
-        }
+    void appendRecord(const string& record) {
+        appendRecords({record});
     }
 
-    void searchByPrefix(const string& prefix) const {
-        FileNode* current = head;
-        bool found = false;
-        int index = 1;
-        
-        while (current) {
-            if (current->filename.find(prefix) == 0) {
-                cout << index++ << ". " << current->filename << endl;
-                current->displayInfo();
-                found = true;
-                current->lastSeenDate = time(nullptr);
+    // Frame several records and hand them to the journal in one write and sync
+    void appendRecords(const vector<string>& records) {
+        string framed;
+        if (!journalOpen()) {
+            error_code ec;
+            if (fs::file_size(journalPath, ec) == 0 || ec) {
+                framed = JOURNAL_MAGIC;
+                writeVarint(framed, generation);
             }
-            current = current->next;
         }
-        
-        if (!found) {
-            cout << "No files found with prefix '" << prefix << "'.\n";
+        for (const string& record : records) {
+            appendFramedRecord(framed, record);
+        }
 
-    
-    vector<FileNode*> searchBySizeRange(size_t minSize, size_t maxSize) {
-        vector<FileNode*> results;
-        FileNode* current = head;
-        while (current) {
-            if (current->type != DIRECTORY && 
-                current->size >= minSize && current->size <= maxSize) {
-                results.push_back(current);
-                current->lastSeenDate = time(nullptr);
+        bool ok;
+#ifndef _WIN32
+        if (journalFd < 0) {
+            journalFd = ::open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        }
+        ok = journalFd >= 0 && writeAll(journalFd, framed) && fdatasync(journalFd) == 0;
+#else
+        if (!journal.is_open()) journal.open(journalPath, ios::binary | ios::app);
+        journal.write(framed.data(), framed.size());
+        journal.flush();
+        ok = static_cast<bool>(journal);
+        journal.clear();
+#endif
+        if (!ok) {
+            cerr << "Error writing catalog journal." << endl;
+        }
+        journalEntries += records.size();
+    }
+
+    bool journalOpen() const {
+#ifndef _WIN32
+        return journalFd >= 0;
+#else
+        return journal.is_open();
+#endif
+    }
+
+    void closeJournal() {
+#ifndef _WIN32
+        if (journalFd >= 0) ::close(journalFd);
+        journalFd = -1;
+#else
+        journal.close();
+        journal.clear();
+#endif
+    }
+
+    void applyRecord(FileList& list, char op, string_view payload) {
+        const char* cursor = payload.data();
+        const char* end = payload.data() + payload.size();
+        string filename, newName;
+        if (!readBytes(cursor, end, filename)) return;
+
+        if (op == OP_ADD) {
+            uint64_t position, size, created, modified, type;
+            if (readVarint(cursor, end, position) && readVarint(cursor, end, size) &&
+                readVarint(cursor, end, created) && readVarint(cursor, end, modified) &&
+                readVarint(cursor, end, type) && type <= OTHER) {
+                list.addRecord(filename, static_cast<FileType>(type), size, static_cast<time_t>(created),
+                               static_cast<time_t>(modified), static_cast<int>(position));
+            }
+        } else if (op == OP_REMOVE) {
+            FileNode* node = list.nameIndex.find(filename);
+            if (node) list.removeNode(node);
+        } else if (op == OP_UPDATE) {
+            uint64_t size, modified, type;
+            FileNode* node = list.nameIndex.find(filename);
+            if (node && readVarint(cursor, end, size) && readVarint(cursor, end, modified)) {
+                list.setFileStats(node, size, static_cast<time_t>(modified));
+                // Journals written before updates carried the type end here
+                if (readVarint(cursor, end, type) && type <= OTHER) node->type = static_cast<FileType>(type);
+            }
+        } else if (op == OP_RENAME) {
+            uint64_t type;
+            FileNode* node = list.nameIndex.find(filename);
+            if (node && readBytes(cursor, end, newName) && readVarint(cursor, end, type) &&
+                type <= OTHER && list.renameFile(node, newName)) {
+                node->type = static_cast<FileType>(type);
             }
-            current = current->next;
         }
-        return results;
+    }
+
+public:
+    // Applies committed records in order; records of an operation that never
+    // committed are dropped.
+    size_t replayJournal(FileList& list) {
+        shared_ptr<const MappedFile> file = MappedFile::open(journalPath);
+        string_view data = file->view();
+        size_t bodyStart = 0;
+        uint64_t journalGeneration = 0;
+        if (!readJournalHeader(data, bodyStart, journalGeneration) || journalGeneration != generation) {
+            return 0;
+        }
+
+        size_t replayed = 0;
+        bool open = false;
+        vector<pair<char, string_view>> pending;
+        scanFramedRecords(data, bodyStart, [&](char op, string_view payload) {
+            replayed++;
+            if (op == OP_BEGIN) {
+                open = true;
+                pending.clear();
+            } else if (op == OP_COMMIT) {
+                for (const auto& record : pending) applyRecord(list, record.first, record.second);
+                open = false;
+                pending.clear();
+            } else if (op == OP_ABORT) {
+                open = false;
+                pending.clear();
+            } else if (open) {
+                pending.push_back({op, payload});
+            } else {
+                applyRecord(list, op, payload);
+            }
+        });
+        journalEntries = replayed;
+        return replayed;
     }
 };
+
 void openInFileExplorer(const string& path) {
     #ifdef _WIN32
         string command = "explorer \"" + path + "\"";
@@ -693,8 +4981,36 @@ void openInFileExplorer(const string& path) {
 // File manager 
 struct FileManager {
 
+    static constexpr const char* CONTENT_INDEX_FILE = "content.idx";
+
     FileList fileList;
     RecycleBin recycleBin;
+    CatalogStore catalog;
+
+    // Result of the last disk usage walk, which Memory Status shows without
+    // walking again
+    struct DiskUsage {
+        bool measured = false;
+        string path;
+        DirectoryTotals totals;
+        bool hasBin = false;
+        uint64_t binBytes = 0;
+        size_t unreadable = 0;
+        double elapsedMs = 0;
+        time_t walkedAt = 0;
+    };
+    DiskUsage lastDiskUsage;
+
+    ~FileManager() {
+        saveContentIndex();
+    }
+
+    void saveContentIndex() {
+        if (fileList.contentIndexEnabled && fileList.contentIndex.dirty &&
+            !fileList.contentIndex.save(CONTENT_INDEX_FILE)) {
+            cerr << "Error saving keyword index." << endl;
+        }
+    }
 
      void showFileLocation() const {
         string path = fs::current_path().string(); // Gets program's current directory
@@ -702,22 +5018,6 @@ struct FileManager {
         openInFileExplorer(path);
     }
 
-    string readFileContent(const string& filename) {
-        if (getFileType(filename) == DIRECTORY) {
-            return "";
-        }
-
-        ifstream file(filename);
-        string content, line;
-        if (file.is_open()) {
-            while (getline(file, line)) {
-                content += line + "\n";
-            }
-            file.close();
-        }
-        return content;
-    }
-
     void displayFileStats(const string& filename) const {
         const FileNode* fileNode = fileList.getFileNode(filename);
         if (fileNode) {
@@ -742,11 +5042,122 @@ struct FileManager {
             totalSize += pair.second;
         }
 
-        cout << "----------------------------------------\n";
-        cout << left << setw(12) << "Total" << ": " 
-             << right << setw(12) << totalSize << " bytes ("
-             << fixed << setprecision(2) << (totalSize / 1024.0) << " KB, "
-             << (totalSize / (1024.0 * 1024.0)) << " MB)\n";
+        cout << "----------------------------------------\n";
+        cout << left << setw(12) << "Total" << ": " 
+             << right << setw(12) << totalSize << " bytes ("
+             << fixed << setprecision(2) << (totalSize / 1024.0) << " KB, "
+             << (totalSize / (1024.0 * 1024.0)) << " MB)\n";
+
+        const ContentCache& cache = fileList.contentCache;
+        cout << "\nContent Cache:\n";
+        cout << "----------------------------------------\n";
+        cout << left << setw(12) << "Entries" << ": " << right << setw(12) << cache.lookup.size() << "\n";
+        cout << left << setw(12) << "Used" << ": " << right << setw(12) << cache.usedBytes << " bytes ("
+             << fixed << setprecision(2) << (cache.usedBytes / (1024.0 * 1024.0)) << " MB)\n";
+        cout << left << setw(12) << "Limit" << ": " << right << setw(12) << cache.capacityBytes << " bytes ("
+             << fixed << setprecision(2) << (cache.capacityBytes / (1024.0 * 1024.0)) << " MB)\n";
+        cout << left << setw(12) << "Hits" << ": " << right << setw(12) << cache.hits << "\n";
+        cout << left << setw(12) << "Misses" << ": " << right << setw(12) << cache.misses << "\n";
+
+        // The walk is only repeated on request; Memory Status stays instant
+        if (lastDiskUsage.measured) {
+            printDiskUsage(lastDiskUsage);
+        } else {
+            cout << "\nOn Disk: not measured yet (View Directory Contents, option 3).\n";
+        }
+
+        const NodePool& pool = fileList.nodePool;
+        const StringArena& names = fileList.names;
+        cout << "\nCatalog Allocation:\n";
+        cout << "----------------------------------------\n";
+        cout << left << setw(12) << "Nodes" << ": " << right << setw(12) << pool.liveNodes << " in "
+             << pool.slabs.size() << " slabs of " << NodePool::SLAB_NODES << "\n";
+        cout << left << setw(12) << "Names" << ": " << right << setw(12) << names.bytesUsed << " bytes in "
+             << names.blocks.size() << " blocks (" << names.reservedBytes() << " bytes reserved, "
+             << names.deadBytes << " dead, " << names.compactions << " compactions)\n";
+        cout << left << setw(12) << "Allocations" << ": " << right << setw(12)
+             << (pool.slabAllocations + names.blockAllocations) << " slabs and blocks since start\n";
+    }
+
+    // Walk path with the parallel TreeWalker and keep its per-type totals,
+    // and the bin's, as the last disk usage
+    bool measureDiskUsage(const string& path) {
+        ThreadPool pool;
+        TreeWalker walker(&pool);
+        if (!walker.walk(path)) return false;
+
+        DiskUsage usage;
+        usage.measured = true;
+        usage.path = path;
+        usage.totals = walker.totals();
+        size_t bin = walker.find((fs::path(path) / recycleBin.binPath).string());
+        usage.hasBin = bin != TreeWalker::NO_PARENT;
+        if (usage.hasBin) usage.binBytes = walker.directories[bin].total.bytes;
+        usage.unreadable = walker.unreadable;
+        usage.elapsedMs = walker.elapsedMs;
+        usage.walkedAt = time(nullptr);
+        lastDiskUsage = move(usage);
+        return true;
+    }
+
+    static void printDiskUsage(const DiskUsage& usage) {
+        const DirectoryTotals& totals = usage.totals;
+        cout << "\nOn Disk ('" << usage.path << "', " << totals.files << " files in " << totals.directories
+             << " directories, walked " << formatTime(usage.walkedAt) << " in " << fixed << setprecision(1)
+             << usage.elapsedMs << " ms):\n";
+        cout << "----------------------------------------\n";
+        for (int type = 0; type <= OTHER; type++) {
+            if (totals.filesByType[type] == 0) continue;
+            cout << left << setw(12) << fileTypeToString(static_cast<FileType>(type)) << ": " << right << setw(12)
+                 << totals.bytesByType[type] << " bytes (" << formatBytes(totals.bytesByType[type]) << ", "
+                 << totals.filesByType[type] << " files)\n";
+        }
+        if (usage.hasBin) {
+            cout << left << setw(12) << "Recycle Bin" << ": " << right << setw(12)
+                 << usage.binBytes << " bytes (" << formatBytes(usage.binBytes) << ")\n";
+        }
+        cout << "----------------------------------------\n";
+        cout << left << setw(12) << "Total" << ": " << right << setw(12) << totals.bytes << " bytes ("
+             << formatBytes(totals.bytes) << ")\n";
+        if (usage.unreadable > 0) cout << usage.unreadable << " directories could not be read.\n";
+    }
+
+    // Walk path now and show what it holds on disk, by type, with the
+    // recycle bin's share when the bin lies inside it
+    void displayDiskUsage(const string& path) {
+        if (!measureDiskUsage(path)) {
+            cout << "\nCannot read '" << path << "'.\n";
+            return;
+        }
+        printDiskUsage(lastDiskUsage);
+    }
+
+    void displayTree(const string& path, int maxDepth) const {
+        ThreadPool pool;
+        TreeWalker walker(&pool);
+        if (!walker.walk(path)) {
+            cerr << "Error reading directory: " << path << endl;
+            return;
+        }
+        {
+            OutputBuffer out(cout);
+            out.append("\n");
+            walker.printTree(out, maxDepth);
+        }
+        const DirectoryTotals& totals = walker.totals();
+        cout << "\n" << totals.directories << " directories, " << totals.files << " files, "
+             << formatBytes(totals.bytes) << " in " << fixed << setprecision(1) << walker.elapsedMs << " ms\n";
+        for (int type = 0; type <= OTHER; type++) {
+            if (totals.filesByType[type] == 0) continue;
+            cout << "  " << left << setw(10) << fileTypeToString(static_cast<FileType>(type)) << right
+                 << setw(10) << totals.filesByType[type] << " files  " << formatBytes(totals.bytesByType[type]) << "\n";
+        }
+        if (walker.unreadable > 0) cout << walker.unreadable << " directories could not be read.\n";
+    }
+
+    void setContentCacheLimit(size_t megabytes) {
+        fileList.contentCache.setCapacity(megabytes * 1024 * 1024);
+        cout << "Content cache limit set to " << megabytes << " MB.\n";
     }
 
 public:
@@ -765,8 +5176,12 @@ public:
     ofstream file(filename);
     if (file.is_open()) {
         file.close();
-        fileList.addFile(filename, readFileContent(filename), position);
-        saveFiles();
+        fileList.addFile(filename, position);
+        FileNode* fileNode = fileList.getFileNode(filename);
+        if (fileNode) {
+            fileList.indexContent(fileNode);
+            recordAdd(fileNode, position);
+        }
         cout << "File created: " << filename << endl;
     } else {
         cout << "Failed to create file: " << filename << endl;
@@ -782,8 +5197,9 @@ public:
         try {
             if (fs::create_directory(dirname)) {
                 cout << "Directory '" << dirname << "' created successfully.\n";
-                fileList.addFile(dirname, "", position);
-                saveFiles();
+                fileList.addFile(dirname, position);
+                FileNode* fileNode = fileList.getFileNode(dirname);
+                if (fileNode) recordAdd(fileNode, position);
             } else {
                 cout << "Failed to create directory '" << dirname << "'.\n";
             }
@@ -791,66 +5207,124 @@ public:
             cerr << "Error creating directory: " << e.what() << endl;
         }
     }
- void updateFileContent(const string& filename, const string& content) {
-        FileNode* fileNode = getFileNode(filename);
-        if (fileNode) {
-            fileNode->content = content;
-            fileNode->updateFileStats();
-        }
-    }
-
-    string getFileContent(const string& filename) const {
-        const FileNode* fileNode = getFileNode(filename);
-        return fileNode ? fileNode->content : "";
-    }
 
-    void sortFiles(int criteria) {
-        switch (criteria) {
-            case 1: sortByName(); break;
-            case 2: sortBySize(); break;
-            case 3: sortByModifiedDate(); break;
-            default: cout << "Invalid sorting criteria.\n";
+    // Recognises the program's own files among entries walked from root,
+    // however root was spelled. Everything is compared as a weakly canonical
+    // path. Root is resolved once; the walk never follows symlinks, so an
+    // entry's canonical path is the canonical root joined with the rest of
+    // its name.
+    struct ProgramDataFilter {
+        string root;
+        string canonicalRoot;
+        vector<string> files; // Each file and its ".tmp" twin from atomic rewrites
+        string directory;
+
+        ProgramDataFilter(const string& walkRoot, initializer_list<string> programFiles,
+                          const string& programDirectory) : root(walkRoot) {
+            canonicalRoot = canonical(walkRoot);
+            if (canonicalRoot.back() != '/') canonicalRoot.push_back('/');
+            for (const string& file : programFiles) {
+                files.push_back(canonical(file));
+                files.push_back(files.back() + ".tmp");
+            }
+            directory = canonical(programDirectory);
         }
-    }
 
-    vector<FileNode*> searchByContent(const string& keyword) {
-        vector<FileNode*> results;
-        FileNode* current = head;
-        while (current) {
-            if (current->type != DIRECTORY && current->content.find(keyword) != string::npos) {
-                results.push_back(current);
-                current->lastSeenDate = time(nullptr);
-            }
-            current = current->next;
+        static string canonical(const string& path) {
+            error_code ec;
+            fs::path resolved = fs::weakly_canonical(path, ec);
+            return ec ? fs::absolute(path, ec).lexically_normal().string() : resolved.string();
         }
-        return results;
-    }
 
-    vector<FileNode*> searchByType(FileType type) {
-        vector<FileNode*> results;
-        FileNode* current = head;
-        while (current) {
-            if (current->type == type) {
-                results.push_back(current);
-                current->lastSeenDate = time(nullptr);
+        bool operator()(const string& name) const {
+            if (name.compare(0, root.size(), root) != 0) return false;
+            size_t rest = root.size();
+            while (rest < name.size() && name[rest] == '/') rest++;
+            string path = canonicalRoot;
+            path.append(name, rest, string::npos);
+            return find(files.begin(), files.end(), path) != files.end() ||
+                   (path.compare(0, directory.size(), directory) == 0 &&
+                    (path.size() == directory.size() || path[directory.size()] == '/'));
+        }
+    };
+
+    // Adopt an existing directory tree without reading any file content. The
+    // tree is walked in parallel, each entry becomes a catalog record from one
+    // statx, the list and its indexes take the whole batch at once, and the
+    // catalog is written once at the end. The recycle bin and the program's
+    // own catalog files are never imported.
+    void importDirectoryTree(const string& root) {
+        using Clock = chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+
+        mutex recordsLock;
+        vector<CatalogRecord> records;
+        ThreadPool pool;
+        TreeWalker walker(&pool);
+        walker.collect = [&records, &recordsLock](vector<CatalogRecord>& scanned) {
+            lock_guard<mutex> guard(recordsLock);
+            move(scanned.begin(), scanned.end(), back_inserter(records));
+        };
+
+        mutex progressLock;
+        condition_variable walkDone;
+        bool walking = true;
+        thread progress([&] {
+            unique_lock<mutex> guard(progressLock);
+            while (!walkDone.wait_for(guard, chrono::milliseconds(500), [&walking] { return !walking; })) {
+                double seconds = chrono::duration<double>(Clock::now() - start).count();
+                size_t seen = walker.entriesSeen;
+                cout << "\rScanned " << seen << " entries (" << static_cast<size_t>(seen / seconds)
+                     << " entries/s)" << flush;
             }
-            current = current->next;
+        });
+        bool found = walker.walk(root);
+        {
+            lock_guard<mutex> guard(progressLock);
+            walking = false;
         }
-        return results;
-    }
+        walkDone.notify_all();
+        progress.join();
 
-    vector<FileNode*> searchBySizeRange(size_t minSize, size_t maxSize) {
-        vector<FileNode*> results;
-        FileNode* current = head;
-        while (current) {
-            if (current->type != DIRECTORY && 
-                current->size >= minSize && current->size <= maxSize) {
-                results.push_back(current);
-                current->lastSeenDate = time(nullptr);
+        if (!found) {
+            cout << "Cannot read '" << root << "'.\n";
+            return;
+        }
+        double walkTime = chrono::duration<double, milli>(Clock::now() - start).count();
+
+        // Names as the rest of the catalog spells them, parents before children
+        Clock::time_point phaseStart = Clock::now();
+        ProgramDataFilter isProgramData(root, {catalog.snapshotPath, catalog.journalPath, CONTENT_INDEX_FILE,
+                                               "files.txt"}, recycleBin.binPath);
+        size_t skipped = 0;
+        vector<CatalogRecord> accepted;
+        accepted.reserve(records.size());
+        for (CatalogRecord& record : records) {
+            if (isProgramData(record.filename)) {
+                skipped++;
+                continue;
             }
-            current = current->next;
+            if (record.filename.compare(0, 2, "./") == 0) record.filename.erase(0, 2);
+            accepted.push_back(move(record));
         }
-        return results;
+        sort(accepted.begin(), accepted.end(), [](const CatalogRecord& a, const CatalogRecord& b) {
+            return a.filename < b.filename;
+        });
+        size_t added = fileList.appendRecords(accepted);
+        double buildTime = chrono::duration<double, milli>(Clock::now() - phaseStart).count();
+
+        phaseStart = Clock::now();
+        if (added > 0) saveFiles();
+        double saveTime = chrono::duration<double, milli>(Clock::now() - phaseStart).count();
+
+        double totalSeconds = chrono::duration<double>(Clock::now() - start).count();
+        cout << "\rImported " << added << " of " << walker.entriesSeen << " entries ("
+             << accepted.size() - added << " already in the catalog, " << skipped << " program data, "
+             << formatBytes(walker.totals().bytes) << ").\n";
+        cout << fixed << setprecision(1) << "walk " << walkTime << " ms, build " << buildTime
+             << " ms, save " << saveTime << " ms; "
+             << static_cast<size_t>(walker.entriesSeen / max(totalSeconds, 1e-6)) << " entries/s\n";
+        if (walker.unreadable > 0) cout << walker.unreadable << " directories could not be read.\n";
     }
 
     void readFile(const string& filename) {
@@ -865,12 +5339,11 @@ public:
             return;
         }
 
-        string content = readFileContent(filename);
-        if (!content.empty()) {
+        shared_ptr<const MappedFile> content = fileList.reloadContent(fileNode);
+        if (!content->empty()) {
             cout << "Contents of '" << filename << "':\n";
-            cout << content;
-            fileList.updateFileContent(filename, content);
-            saveFiles();
+            cout.write(content->data, content->size());
+            recordUpdate(fileNode);
         } else {
             cout << "File is empty or couldn't be read.\n";
         }
@@ -894,9 +5367,8 @@ public:
             cout << "Content appended to '" << filename << "' successfully.\n";
             file.close();
             
-            string currentContent = fileList.getFileContent(filename);
-            fileList.updateFileContent(filename, currentContent + content + "\n");
-            saveFiles();
+            fileList.appendFileContent(filename, content + "\n");
+            recordUpdate(fileNode);
         } else {
             cout << "Error: Unable to open file '" << filename << "'.\n";
         }
@@ -921,7 +5393,7 @@ public:
             file.close();
             
             fileList.updateFileContent(filename, content);
-            saveFiles();
+            recordUpdate(fileNode);
         } else {
             cout << "Error: Unable to open file '" << filename << "'.\n";
         }
@@ -933,24 +5405,24 @@ public:
             return;
         }
 
-        FileNode* fileNode;
-        if (position == -1) {
-            fileNode = fileList.getFileNode(fileList.size() - 1);
-        } else if (position == 0) {
-            fileNode = fileList.getFileNode(0);
-        } else {
-            fileNode = fileList.getFileNode(position);
-        }
-
+        // One walk to find the node; unlinking it afterwards is O(1)
+        FileNode* fileNode = position == -1 ? fileList.tail : fileList.getFileNode(position);
         if (!fileNode) {
             cout << "Invalid file position.\n";
             return;
         }
 
-        string filename = fileNode->filename;
+        string filename(fileNode->filename);
+        catalog.begin();
+        catalog.recordRemove(filename);
+        catalog.prepare();
         if (recycleBin.addToBin(filename)) {
-            fileList.removeFile(position);
-            saveFiles();
+            fileList.removeNode(fileNode);
+            cout << "File '" << filename << "' removed.\n";
+            catalog.commit();
+            compactCatalogIfNeeded();
+        } else {
+            catalog.abort();
         }
     }
 
@@ -966,10 +5438,103 @@ public:
             return;
         }
 
+        catalog.begin();
+        catalog.recordRemove(filename);
+        catalog.prepare();
         if (recycleBin.addToBin(filename)) {
             fileList.removeFile(filename);
-            saveFiles();
+            catalog.commit();
+            compactCatalogIfNeeded();
+        } else {
+            catalog.abort();
+        }
+    }
+
+    // Batch delete: the removals are logged as one operation before anything
+    // moves, the files go to the recycle bin together (in parallel for large
+    // batches), and the moved entries are unlinked in one pass. Returns how
+    // many were deleted.
+    size_t deleteFiles(const vector<string>& filenames) {
+        auto started = chrono::steady_clock::now();
+
+        vector<string> targets;
+        targets.reserve(filenames.size());
+        unordered_set<string> requested;
+        size_t unknown = 0;
+        for (const string& filename : filenames) {
+            if (!requested.insert(filename).second) continue;
+            if (fileList.contains(filename)) {
+                targets.push_back(filename);
+            } else {
+                unknown++;
+            }
+        }
+        if (unknown > 0) {
+            cout << unknown << " name(s) not found in managed list.\n";
+        }
+        if (targets.empty()) return 0;
+
+        catalog.begin();
+        for (const string& filename : targets) {
+            catalog.recordRemove(filename);
+        }
+        catalog.prepare();
+
+        vector<string> moved;
+        moved.reserve(targets.size());
+        recycleBin.addToBin(targets, &moved);
+
+        if (moved.size() == targets.size()) {
+            catalog.commit();
+        } else if (moved.empty()) {
+            catalog.abort();
+        } else {
+            // Commit just the removals that happened, superseding the open group
+            catalog.begin();
+            for (const string& filename : moved) {
+                catalog.recordRemove(filename);
+            }
+            catalog.commit();
+        }
+
+        vector<FileNode*> nodes;
+        nodes.reserve(moved.size());
+        for (const string& filename : moved) {
+            nodes.push_back(fileList.nameIndex.find(filename));
+        }
+        fileList.removeNodes(nodes);
+        compactCatalogIfNeeded();
+
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        cout << "Moved " << moved.size() << " of " << targets.size() << " file(s) to the Recycle Bin in "
+             << fixed << setprecision(2) << elapsed << " s.\n";
+        return moved.size();
+    }
+
+    // Delete every managed entry for which pred(node) is true
+    template <typename Predicate>
+    size_t deleteFilesWhere(Predicate pred) {
+        vector<string> filenames;
+        for (const FileNode* current = fileList.head; current; current = current->next) {
+            if (pred(*current)) filenames.emplace_back(current->filename);
+        }
+        return deleteFiles(filenames);
+    }
+
+    void deleteFilesByNames() {
+        cout << "Enter filenames, one per line (empty line to finish):\n";
+        vector<string> filenames;
+        string filename;
+        while (getline(cin, filename) && !filename.empty()) {
+            filenames.push_back(filename);
         }
+        deleteFiles(filenames);
+    }
+
+    void deleteFilesByType() {
+        FileType type;
+        if (!promptFileType("delete", type)) return;
+        deleteFilesWhere([type](const FileNode& node) { return node.type == type; });
     }
 
     void deleteAllFiles() {
@@ -984,15 +5549,10 @@ public:
         cin.ignore(numeric_limits<streamsize>::max(), '\n');
         if (confirm != 'y' && confirm != 'Y') return;
 
-        FileNode* current = fileList.getFileNode(0);
-        while (current) {
-            recycleBin.addToBin(current->filename);
-            current = current->next;
+        size_t total = fileList.size();
+        if (deleteFilesWhere([](const FileNode&) { return true; }) == total) {
+            cout << "All files and directories moved to Recycle Bin.\n";
         }
-        
-        fileList.clear();
-        saveFiles();
-        cout << "All files and directories moved to Recycle Bin.\n";
     }
 
     void listFiles() const {
@@ -1016,12 +5576,29 @@ public:
         fileList.searchByPrefix(prefix);
     }
 
+    void completeFilename() {
+        const size_t suggestionCount = 10;
+        string prefix;
+        cout << "Enter the start of a filename: ";
+        getline(cin, prefix);
+
+        vector<string> names = fileList.completeName(prefix, suggestionCount);
+        if (names.empty()) {
+            cout << "No files found with prefix '" << prefix << "'.\n";
+            return;
+        }
+        cout << "Suggestions:\n";
+        for (size_t i = 0; i < names.size(); i++) {
+            cout << "  " << names[i] << "\n";
+        }
+    }
+
 
 void updateFileMetadata(const string& filename) {
         FileNode* fileNode = fileList.getFileNode(filename);
         if (fileNode) {
-            fileNode->updateFileStats();
-            saveFiles();
+            fileList.refreshFileStats(fileNode);
+            recordUpdate(fileNode);
             cout << "Metadata updated for " << filename << ".\n";
         } else {
             cout << "File not found.\n";
@@ -1033,21 +5610,90 @@ void updateFileMetadata(const string& filename) {
         cout << "Enter content keyword to search: ";
         getline(cin, keyword);
         
-        vector<FileNode*> results = fileList.searchByContent(keyword);
+        vector<ContentMatch> results = fileList.searchByContent(keyword);
         if (results.empty()) {
             cout << "No files found containing '" << keyword << "'.\n";
         } else {
             cout << "Files containing '" << keyword << "':\n";
             for (size_t i = 0; i < results.size(); i++) {
-                cout << i+1 << ". " << results[i]->filename << " (" 
-                     << fileTypeToString(results[i]->type) << ")\n";
+                const ContentMatch& match = results[i];
+                cout << i+1 << ". " << match.node->filename << " (" 
+                     << fileTypeToString(match.node->type) << ") - "
+                     << match.matchCount << (match.matchCount == 1 ? " match" : " matches")
+                     << " at offset";
+                for (size_t j = 0; j < match.offsets.size(); j++) {
+                    cout << (j == 0 ? " " : ", ") << match.offsets[j];
+                }
+                if (match.matchCount > match.offsets.size()) cout << ", ...";
+                cout << "\n";
             }
         }
     }
 
-    void searchFilesByType() {
+    void configureSearch() {
+        SearchOptions options = fileList.searchOptions;
+        cout << "Current: " << (options.threads == 0 ? "auto" : to_string(options.threads))
+             << " threads, " << options.chunkSize << " files per chunk\n";
+        cout << "Enter thread count (0 = one per core): ";
+        cin >> options.threads;
+        cout << "Enter chunk size (files per task): ";
+        cin >> options.chunkSize;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        fileList.setSearchOptions(options);
+
+        cout << "Keyword index is " << (fileList.contentIndexEnabled ? "on" : "off")
+             << ". Use keyword index? (y/n): ";
+        char useIndex;
+        cin >> useIndex;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        setContentIndexEnabled(useIndex == 'y' || useIndex == 'Y');
+        cout << "Search settings updated.\n";
+    }
+
+    void setContentIndexEnabled(bool enabled) {
+        if (enabled == fileList.contentIndexEnabled) return;
+
+        fileList.contentIndexEnabled = enabled;
+        if (enabled) {
+            cout << "Building keyword index...\n";
+            fileList.buildContentIndex(CONTENT_INDEX_FILE);
+            saveContentIndex();
+            cout << "Indexed " << fileList.contentIndex.documents.size() << " files, "
+                 << fileList.contentIndex.postings.size() << " distinct words.\n";
+        } else {
+            fileList.contentIndex.clear();
+            error_code ec;
+            fs::remove(CONTENT_INDEX_FILE, ec);
+        }
+    }
+
+    void searchFilesByKeywords() {
+        if (!fileList.contentIndexEnabled) {
+            cout << "Keyword index is off. Turn it on under Search Settings.\n";
+            return;
+        }
+
+        string query;
+        cout << "Enter keyword or phrase: ";
+        getline(cin, query);
+
+        vector<ContentMatch> results = fileList.searchByKeywords(query);
+        if (results.empty()) {
+            cout << "No files found containing '" << query << "'.\n";
+        } else {
+            cout << "Files containing '" << query << "':\n";
+            for (size_t i = 0; i < results.size(); i++) {
+                cout << i+1 << ". " << results[i].node->filename << " ("
+                     << fileTypeToString(results[i].node->type) << ") - "
+                     << results[i].matchCount << (results[i].matchCount == 1 ? " match" : " matches") << "\n";
+            }
+        }
+    }
+
+    bool promptFileType(const string& action, FileType& type) const {
         cout << "----------------------------------------\n";
-        cout << "Select file type to search:\n";
+        cout << "Select file type to " << action << ":\n";
         cout << "1. Document\n";
         cout << "2. Image\n";
         cout << "3. Audio\n";
@@ -1061,7 +5707,6 @@ void updateFileMetadata(const string& filename) {
         cin >> choice;
         cin.ignore(numeric_limits<streamsize>::max(), '\n');
         
-        FileType type;
         switch (choice) {
             case 1: type = DOCUMENT; break;
             case 2: type = IMAGE; break;
@@ -1072,8 +5717,14 @@ void updateFileMetadata(const string& filename) {
             case 7: type = OTHER; break;
             default: 
                 cout << "Invalid choice.\n";
-                return;
+                return false;
         }
+        return true;
+    }
+
+    void searchFilesByType() {
+        FileType type;
+        if (!promptFileType("search", type)) return;
         
         vector<FileNode*> results = fileList.searchByType(type);
         if (results.empty()) {
@@ -1086,6 +5737,16 @@ void updateFileMetadata(const string& filename) {
         }
     }
 
+    // Types live in the snapshot, so a reclassification is saved in one write
+    void detectFileTypesFromContent() {
+        auto start = chrono::steady_clock::now();
+        size_t changed = fileList.detectContentTypes();
+        double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (changed > 0) saveFiles();
+        cout << "Checked the contents of " << fileList.size() << " entries in " << fixed << setprecision(1)
+             << elapsed << " ms; " << changed << " changed type.\n";
+    }
+
     void searchFilesBySizeRange() {
         size_t minSize, maxSize;
         cout << "Enter minimum size (bytes): ";
@@ -1111,44 +5772,111 @@ void updateFileMetadata(const string& filename) {
         }
     }
 
-    void displayDirectoryContents(const string& path = ".") const {
-        try {
-            cout << "\nContents of directory '" << path << "':\n";
-            int count = 1;
-            
-            for (const auto& entry : fs::directory_iterator(path)) {
-                string filename = entry.path().filename().string();
-                FileType type = getFileType(entry.path().string());
-                
-                cout << count++ << ". " << filename << " (" << fileTypeToString(type) << ")\n";
-                
-                if (type != DIRECTORY) {
-                    cout << "   Size: " << entry.file_size() << " bytes\n";
-                }
-                
-                auto ftime = entry.last_write_time();
-                time_t cftime = chrono::system_clock::to_time_t(
-                    chrono::time_point_cast<chrono::system_clock::duration>(
-                        ftime - decltype(ftime)::clock::now() + chrono::system_clock::now()
-                    )
-                );
-                cout << "   Modified: " << formatTime(cftime);
+    void searchFilesByModifiedDate() {
+        int days;
+        cout << "Show files modified within the last N days. Enter N: ";
+        cin >> days;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        if (days < 0) {
+            cout << "Invalid number of days.\n";
+            return;
+        }
+
+        time_t now = time(nullptr);
+        vector<FileNode*> results = fileList.searchByModifiedRange(now - static_cast<time_t>(days) * 24 * 60 * 60, now);
+        if (results.empty()) {
+            cout << "No files modified in the last " << days << " days.\n";
+        } else {
+            cout << "Files modified in the last " << days << " days:\n";
+            for (size_t i = 0; i < results.size(); i++) {
+                cout << i+1 << ". " << results[i]->filename << " ("
+                     << formatTime(results[i]->lastModified) << ")\n";
             }
-        } catch (const exception& e) {
-            cerr << "Error reading directory: " << e.what() << endl;
-=======
+        }
+    }
+
+    void displayDirectoryContents(const string& path = ".", const ListingOptions& options = ListingOptions()) const {
+        auto start = chrono::steady_clock::now();
+        DirectoryLister lister(path, options);
+        {
+            OutputBuffer out(cout);
+            out.append("\nContents of directory '");
+            out.append(path);
+            out.append("':\n");
+            try {
+                lister.run(out);
+            } catch (const exception& e) {
+                out.flush();
+                cerr << "Error reading directory: " << e.what() << endl;
+                return;
+            }
+        }
+        double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "\nListed " << lister.listed << " entries in " << fixed << setprecision(1) << elapsed
+             << " ms (" << lister.statCalls << " stat calls).\n";
+    }
+
+    void viewDirectoryContents() {
+        cout << "Enter directory path (leave empty for current): ";
+        string path;
+        getline(cin, path);
+        if (path.empty()) path = ".";
+
+        int mode;
+        cout << "1. List entries\n2. Tree with sizes\n3. Disk usage by type\nEnter choice: ";
+        cin >> mode;
+        if (mode == 3) {
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            displayDiskUsage(path);
+            return;
+        }
+        if (mode == 2) {
+            int maxDepth;
+            cout << "Maximum depth (0 = no limit): ";
+            cin >> maxDepth;
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            displayTree(path, maxDepth);
+            return;
+        }
+
+        ListingOptions options;
+        int sortChoice;
+        cout << "Sort by (0 = directory order, 1 = name, 2 = size, 3 = modification date): ";
+        cin >> sortChoice;
+        if (sortChoice >= 1 && sortChoice <= 3) {
+            options.sortKey = static_cast<ListingOptions::SortKey>(sortChoice);
+            char descending;
+            cout << "Descending order? (y/n): ";
+            cin >> descending;
+            options.descending = (descending == 'y' || descending == 'Y');
+        }
+        cout << "Show only the first N entries (0 = all): ";
+        cin >> options.limit;
+        cout << "Entries per page (0 = no paging): ";
+        cin >> options.pageSize;
+        char details;
+        cout << "Show size and modification date? (y/n): ";
+        cin >> details;
+        options.details = (details == 'y' || details == 'Y');
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        displayDirectoryContents(path, options);
+    }
+
     void fileStatistics(const string& filename) const {
         displayFileStats(filename);
     }
 
-    void displayFileContent(const string& filename) const {
-        const FileNode* fileNode = fileList.getFileNode(filename);
+    void displayFileContent(const string& filename) {
+        FileNode* fileNode = fileList.getFileNode(filename);
         if (fileNode) {
             if (fileNode->type == DIRECTORY) {
                 cout << filename << " is a directory.\n";
             } else {
-                cout << "Content of " << filename << " from memory:\n";
-                cout << fileNode->content;
+                cout << "Content of " << filename << ":\n";
+                shared_ptr<const MappedFile> content = fileList.loadContent(fileNode);
+                cout.write(content->data, content->size());
             }
         } else {
             cout << "File not found in memory.\n";
@@ -1161,7 +5889,7 @@ void updateFileMetadata(const string& filename) {
         cout << "Files sorted successfully.\n";
     }
 
-    void retrieveFileContent(const string& filename) const {
+    void retrieveFileContent(const string& filename) {
         displayFileContent(filename);
     }
 
@@ -1173,13 +5901,21 @@ void updateFileMetadata(const string& filename) {
                 return;
             }
             
+            // Renaming leaves the content alone, so the type found by sniffing
+            // (or an earlier rename) stands; only content updates re-detect it
+            FileType newType = fileNode->type;
+            catalog.begin();
+            catalog.recordRename(oldName, newName, newType);
+            catalog.prepare();
             try {
                 fs::rename(oldName, newName);
-                fileNode->filename = newName;
-                fileNode->type = getFileType(newName);
-                saveFiles();
+                fileList.renameFile(fileNode, newName);
+                fileNode->type = newType;
+                catalog.commit();
+                compactCatalogIfNeeded();
                 cout << "File renamed from '" << oldName << "' to '" << newName << "' successfully.\n";
             } catch (const exception& e) {
+                catalog.abort();
                 cerr << "Error renaming: " << e.what() << endl;
             }
         } else {
@@ -1187,14 +5923,30 @@ void updateFileMetadata(const string& filename) {
         }
     }
 
+    // A positive item number as typed in the recycle bin menu
+    static bool parseItemNumber(const string& text, size_t& number) {
+        if (text.empty() || text.size() > 18 ||
+            !all_of(text.begin(), text.end(), [](unsigned char c) { return isdigit(c) != 0; })) {
+            return false;
+        }
+        number = stoull(text);
+        return number > 0;
+    }
+
         void manageRecycleBin() {
         while (true) {
             cout << "----------------------------------------\n";
-            cout << "\nRecycle Bin Management (" << recycleBin.size() << " items)\n";
+            cout << "\nRecycle Bin Management (" << recycleBin.size() << " items, "
+                 << fixed << setprecision(2) << (recycleBin.usedBytes() / (1024.0 * 1024.0)) << " of "
+                 << (recycleBin.maxStorage / (1024.0 * 1024.0)) << " MB)\n";
             cout << "1. List items\n";
             cout << "2. Restore item\n";
             cout << "3. Delete item permanently\n";
             cout << "4. Empty Recycle Bin\n";
+            cout << "5. Background size check ("
+                 << (recycleBin.reconcilerRunning() ? "on" : "off") << ")\n";
+            cout << "6. List recently deleted items\n";
+            cout << "7. Eviction settings\n";
             cout << "0. Back to Main Menu\n";
             cout << "----------------------------------------\n";
             cout << "Enter your choice: ";
@@ -1210,24 +5962,28 @@ void updateFileMetadata(const string& filename) {
                     recycleBin.listItems();
                     break;
                 case 2: {
-                    cout << "Enter item number to restore: ";
+                    cout << "Enter item number or original path to restore: ";
+                    string target;
+                    getline(cin, target);
                     size_t index;
-                    cin >> index;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    if (index > 0) {
-                        recycleBin.restoreItem(index - 1);
+                    if (parseItemNumber(target, index)) {
+                        recycleBin.restoreItem(static_cast<uint64_t>(index));
+                    } else if (!target.empty()) {
+                        recycleBin.restoreItem(target);
                     } else {
                         cout << "Invalid index.\n";
                     }
                     break;
                 }
                 case 3: {
-                    cout << "Enter item number to delete permanently: ";
+                    cout << "Enter item number or original path to delete permanently: ";
+                    string target;
+                    getline(cin, target);
                     size_t index;
-                    cin >> index;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    if (index > 0) {
-                        recycleBin.deleteItem(index - 1, true);
+                    if (parseItemNumber(target, index)) {
+                        recycleBin.deleteItem(static_cast<uint64_t>(index), true);
+                    } else if (!target.empty()) {
+                        recycleBin.deleteItem(target, true);
                     } else {
                         cout << "Invalid index.\n";
                     }
@@ -1242,39 +5998,197 @@ void updateFileMetadata(const string& filename) {
                         recycleBin.emptyBin();
                     }
                     break;
+                case 5:
+                    if (recycleBin.reconcilerRunning()) {
+                        recycleBin.stopReconciler();
+                        cout << "Background size check stopped after " << recycleBin.reconcilePasses
+                             << " passes.\n";
+                    } else {
+                        cout << "Rescan interval in seconds: ";
+                        long seconds;
+                        cin >> seconds;
+                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                        recycleBin.reconcile(); // Catch up now, then at the chosen rate
+                        recycleBin.startReconciler(chrono::seconds(max(1L, seconds)));
+                        cout << "Background size check started.\n";
+                    }
+                    break;
+                case 6: {
+                    cout << "Show items deleted in the last how many hours? ";
+                    long hours;
+                    cin >> hours;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    recycleBin.listItemsDeletedSince(time(nullptr) - max(0L, hours) * 3600);
+                    break;
+                }
+                case 7: {
+                    recycleBin.displayEvictionStats();
+                    cout << "When full: 0. Refuse  1. Purge oldest  2. Purge largest past an age\n";
+                    cout << "Enter policy: ";
+                    int policy;
+                    cin >> policy;
+                    long minAgeHours = 0;
+                    if (policy == RecycleBin::EVICT_LARGEST_PAST_AGE) {
+                        cout << "Minimum age in hours: ";
+                        cin >> minAgeHours;
+                    }
+                    cout << "Expire items after how many days (0 = never): ";
+                    long retentionDays;
+                    cin >> retentionDays;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    if (policy < RecycleBin::EVICT_NONE || policy > RecycleBin::EVICT_LARGEST_PAST_AGE) {
+                        cout << "Invalid policy.\n";
+                        break;
+                    }
+                    recycleBin.setEvictionPolicy(static_cast<RecycleBin::EvictionPolicy>(policy),
+                                                 max(0L, minAgeHours) * 3600, max(0L, retentionDays) * 86400);
+                    cout << "Eviction settings updated.\n";
+                    break;
+                }
                 default:
                     cout << "Invalid choice.\n";
             }
         }
     }
 
+    // Finish or undo whatever the last session left half-written. Runs before
+    // loadFiles; cost is proportional to the journal, not the catalog.
+    void recoverFromCrash() {
+        error_code ec;
+        fs::remove(string(CONTENT_INDEX_FILE) + ".tmp", ec);
+
+        CatalogStore::RecoveryReport report = catalog.recover();
+        if (report.staleJournal) {
+            cout << "Discarded a catalog journal from before the last snapshot.\n";
+        }
+        if (report.truncatedBytes > 0) {
+            cout << "Recovered catalog journal: dropped " << report.truncatedBytes
+                 << " bytes of incomplete writes.\n";
+        }
+        if (report.rolledForward) {
+            cout << "Completed an interrupted operation from the catalog journal.\n";
+        } else if (report.rolledBack) {
+            cout << "Rolled back an interrupted operation from the catalog journal.\n";
+        }
+    }
+
+    // Startup pipeline: parse the catalog (or the legacy list, stat'ed on a
+    // thread pool), build the list and its indexes in one bulk pass, replay the
+    // journal, then bring the keyword index up to date. Each phase is timed.
     void loadFiles() {
+        using Clock = chrono::steady_clock;
+        auto millisecondsSince = [](Clock::time_point start) {
+            return chrono::duration<double, milli>(Clock::now() - start).count();
+        };
+
+        // Snapshot decoding, legacy stats and the index builds share one pool;
+        // journal replay stays serial since its records depend on order
+        ThreadPool pool;
+        Clock::time_point phaseStart = Clock::now();
+        vector<CatalogRecord> records;
+        bool snapshot = catalog.exists();
+        bool legacy = !snapshot && readLegacyFileList(records);
+        if (snapshot && !catalog.readSnapshot(records, &pool)) {
+            records.clear();
+            string movedTo = catalog.setAsideCorrupt();
+            if (movedTo.empty()) {
+                cout << "Error reading catalog; it could not be moved aside, so changes will only go "
+                        "to the journal until it is repaired or removed.\n";
+            } else {
+                cout << "Error reading catalog; moved it to '" << movedTo << "' and started a new one.\n";
+            }
+        }
+        double parseTime = millisecondsSince(phaseStart);
+
+        phaseStart = Clock::now();
+        if (legacy) statRecords(records, pool);
+        double statTime = millisecondsSince(phaseStart);
+
+        phaseStart = Clock::now();
+        fileList.appendRecords(records, &pool);
+        double buildTime = millisecondsSince(phaseStart);
+
+        phaseStart = Clock::now();
+        // Without a snapshot the journal still holds every change made since
+        // the store was created, so it is replayed in every case
+        size_t journalRecords = catalog.replayJournal(fileList);
+        if (legacy) saveFiles();
+        double journalTime = millisecondsSince(phaseStart);
+
+        // A persisted keyword index means the user turned it on earlier
+        phaseStart = Clock::now();
+        if (fs::exists(CONTENT_INDEX_FILE)) {
+            fileList.contentIndexEnabled = true;
+            fileList.buildContentIndex(CONTENT_INDEX_FILE);
+            saveContentIndex();
+        }
+        double indexTime = millisecondsSince(phaseStart);
+
+        cout << fixed << setprecision(1)
+             << "Loaded " << fileList.size() << " entries (" << journalRecords << " journal records): "
+             << "parse " << parseTime << " ms, stat " << statTime << " ms, build " << buildTime
+             << " ms, journal " << journalTime << " ms, keyword index " << indexTime << " ms\n";
+    }
+
+    // files.txt from older versions only lists names; their metadata is
+    // filled in by statRecords and then migrated into the binary catalog.
+    bool readLegacyFileList(vector<CatalogRecord>& records) {
         ifstream file("files.txt");
         if (!file) {
-            return; // No existing file is okay
+            return false;
         }
         string filename;
         while (getline(file, filename)) {
             if (!filename.empty()) {
-                string content = readFileContent(filename);
-                fileList.addFile(filename, content);
+                records.push_back({filename, OTHER, 0, 0, 0});
             }
         }
         file.close();
+        return true;
     }
 
-    void saveFiles() const {
-        ofstream file("files.txt");
-        if (!file) {
-            cout << "Error saving file list.\n";
-            return;
+    void statRecords(vector<CatalogRecord>& records, ThreadPool& pool) {
+        const size_t chunkSize = 256;
+        time_t now = time(nullptr);
+        for (size_t start = 0; start < records.size(); start += chunkSize) {
+            pool.submit([&records, start, chunkSize, now] {
+                size_t end = min(records.size(), start + chunkSize);
+                for (size_t i = start; i < end; i++) {
+                    CatalogRecord& record = records[i];
+                    error_code ec;
+                    fs::file_status status = fs::status(record.filename, ec);
+                    record.type = getFileType(record.filename, status);
+                    record.size = fs::is_regular_file(status) ? fs::file_size(record.filename, ec) : 0;
+                    if (ec) record.size = 0;
+                    record.created = record.modified = now;
+                }
+            });
         }
-        FileNode* current = fileList.head;
-        while (current) {
-            file << current->filename << '\n';
-            current = current->next;
+        pool.wait();
+    }
+
+    // Write a full catalog snapshot, folding in the journal
+    void saveFiles() {
+        if (!catalog.writeSnapshot(fileList)) {
+            cout << "Error saving file list.\n";
         }
-        file.close();
+    }
+
+    // Called once an operation is finished, so no name views are in flight
+    void compactCatalogIfNeeded() {
+        if (catalog.needsCompaction()) saveFiles();
+        if (fileList.names.needsCompaction()) fileList.compactNames();
+    }
+
+    // Position as passed to FileList::addFile; -1 means it went at the end
+    void recordAdd(const FileNode* fileNode, int position) {
+        catalog.recordAdd(*fileNode, position == -1 ? fileList.size() - 1 : position);
+        compactCatalogIfNeeded();
+    }
+
+    void recordUpdate(const FileNode* fileNode) {
+        catalog.recordUpdate(*fileNode);
+        compactCatalogIfNeeded();
     }
 };
 
@@ -1321,6 +6235,11 @@ void displayAdvancedSearchMenu() {
     cout << "2. Search by Type\n";
     cout << "3. Search by Size Range\n";
     cout << "4. Search by Prefix\n";
+    cout << "5. Search by Modification Date\n";
+    cout << "6. Search Settings\n";
+    cout << "7. Search by Keyword/Phrase (index)\n";
+    cout << "8. Complete Filename\n";
+    cout << "9. Detect File Types from Content\n";
     cout << "0. Back to Main Menu\n";
     cout << "----------------------------------------\n";
     cout << "Enter your choice: ";
@@ -1336,6 +6255,9 @@ void displaySortMenu() {
     cout << "----------------------------------------\n";
     cout << "Enter your choice: ";
 }
+
+// Benchmarks under bench/ include this file and bring their own main
+#ifndef FM_NO_MAIN
 int main() {
     FileManager fm;
     fm.recoverFromCrash();
@@ -1359,12 +6281,19 @@ int main() {
             case 1: { // Create File/Directory
                 cout << "1. Create File\n";
                 cout << "2. Create Directory\n";
+                cout << "3. Import Existing Directory Tree\n";
                 cout << "Enter choice: ";
                 int createChoice;
                 cin >> createChoice;
-                cin.ignore();
                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
+                if (createChoice == 3) {
+                    cout << "Enter directory to import: ";
+                    getline(cin, filename);
+                    fm.importDirectoryTree(filename.empty() ? "." : filename);
+                    break;
+                }
+
                 cout << "Enter name: ";
                 getline(cin, filename);
                 cout << "  To create at the last, enter (-1)\n  To create at the  first, enter (0)\n  Create at specific index\nEnter position: ";
@@ -1386,10 +6315,11 @@ int main() {
             case 2: { // Delete File/Directory
                 cout << "1. Delete by position\n";
                 cout << "2. Delete by name\n";
+                cout << "3. Delete several by name\n";
+                cout << "4. Delete all of a type\n";
                 cout << "Enter choice: ";
                 int deleteChoice;
                 cin >> deleteChoice;
-                cin.ignore();
                 cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
                 if (deleteChoice == 1) {
@@ -1401,6 +6331,10 @@ int main() {
                     cout << "Enter filename: ";
                     getline(cin, filename);
                     fm.deleteFileByName(filename);
+                } else if (deleteChoice == 3) {
+                    fm.deleteFilesByNames();
+                } else if (deleteChoice == 4) {
+                    fm.deleteFilesByType();
                 } else {
                 cout << "|-----------------------------------|\n";
                 cout << "| Invalid choice.                   |\n";
@@ -1416,9 +6350,6 @@ int main() {
                 getline(cin, filename);
 
                 fm.searchFile(filename);
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                fm.searchFile(filename)
-
                 break;
             }
             case 5: { // Sort Files
@@ -1507,6 +6438,21 @@ int main() {
                         case 4:
                           fm.searchFilesByPrefix();
                             break;
+                        case 5:
+                            fm.searchFilesByModifiedDate();
+                            break;
+                        case 6:
+                            fm.configureSearch();
+                            break;
+                        case 7:
+                            fm.searchFilesByKeywords();
+                            break;
+                        case 8:
+                            fm.completeFilename();
+                            break;
+                        case 9:
+                            fm.detectFileTypesFromContent();
+                            break;
                         default:
                             cout << "|-----------------------------------|\n";
                             cout << "| Invalid choice.                   |\n";
@@ -1516,31 +6462,29 @@ int main() {
                 break;
             }
             case 8: // Delete All Files
-                cout << "Are you sure you want to delete all files? (y/n): ";
-                char confirm;
-                cin >> confirm;
-                cin.ignore();
-                if (confirm == 'y' || confirm == 'Y') {
-                    
-                }
+                fm.deleteAllFiles();
                 break;
-            case 9: { // View Directory Contents
-                cout << "Enter directory path (leave empty for current): ";
-                string path;
-                getline(cin, path);
-                if (path.empty()) {
-                   
-                } else {
-                    
-                }
+            case 9: // View Directory Contents
+                fm.viewDirectoryContents();
                 break;
-            }
             case 10: // Manage Recycle Bin
                 fm.manageRecycleBin();
                 break;
-            case 11: // View Memory Status
+            case 11: { // View Memory Status
                 fm.displayMemoryStatus();
+                cout << "Change content cache limit? (y/n): ";
+                char change;
+                cin >> change;
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                if (change == 'y' || change == 'Y') {
+                    size_t megabytes;
+                    cout << "Enter new limit (MB): ";
+                    cin >> megabytes;
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    fm.setContentCacheLimit(megabytes);
+                }
                 break;
+            }
                 case 12:  // Open File Location
                 fm.showFileLocation();
                 break;
@@ -1552,4 +6496,5 @@ int main() {
     }
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
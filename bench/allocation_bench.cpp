@@ -0,0 +1,108 @@
+// Heap allocations per catalog operation, counted by the FileList's
+// AllocationMeters, and what compacting the name arena gives back after
+// heavy renaming. This file replaces the global allocator to do the
+// counting; the program itself never does.
+//
+//   g++ -std=c++17 -O2 -pthread bench/allocation_bench.cpp -o allocation_bench
+//   ./allocation_bench [entries]   (default 100000)
+#define FM_NO_MAIN
+#include "../File Management System.cpp"
+
+#include <new>
+
+// Every replaceable allocation function, so whatever one form allocates the
+// matching form frees, including the nothrow and over-aligned ones
+static void* countedAllocate(size_t size, size_t alignment = 0) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (alignment <= alignof(max_align_t)) return malloc(size);
+    void* memory = nullptr;
+    return posix_memalign(&memory, alignment, size) == 0 ? memory : nullptr;
+}
+
+static void* countedAllocateOrThrow(size_t size, size_t alignment = 0) {
+    if (void* memory = countedAllocate(size, alignment)) return memory;
+    throw bad_alloc();
+}
+
+void* operator new(size_t size) { return countedAllocateOrThrow(size); }
+void* operator new[](size_t size) { return countedAllocateOrThrow(size); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return countedAllocate(size); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return countedAllocate(size); }
+void* operator new(size_t size, align_val_t alignment) {
+    return countedAllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, align_val_t alignment) {
+    return countedAllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    return countedAllocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    return countedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+void operator delete(void* memory, const nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory, const nothrow_t&) noexcept { free(memory); }
+void operator delete(void* memory, align_val_t) noexcept { free(memory); }
+void operator delete[](void* memory, align_val_t) noexcept { free(memory); }
+void operator delete(void* memory, size_t, align_val_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t, align_val_t) noexcept { free(memory); }
+void operator delete(void* memory, align_val_t, const nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory, align_val_t, const nothrow_t&) noexcept { free(memory); }
+
+static string nameFor(size_t i, int generation) {
+    // 40-byte names, as in a typical nested project tree
+    string name = "projects/client-" + to_string(i % 97) + "/g" + to_string(generation) + "/file-" + to_string(i);
+    name.resize(40, '_');
+    return name;
+}
+
+static void report(const char* label, const AllocationStats& stats) {
+    cout << left << setw(10) << label << right << fixed << setprecision(2) << setw(8)
+         << stats.perOperation() << " allocations/op over " << stats.operations << "\n";
+}
+
+int main(int argc, char** argv) {
+    size_t entries = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000;
+    FileList list;
+
+    vector<CatalogRecord> records;
+    records.reserve(entries);
+    for (size_t i = 0; i < entries; i++) {
+        records.push_back({nameFor(i, 0), DOCUMENT, i % 4096, 0, static_cast<time_t>(i)});
+    }
+    list.appendRecords(records);
+
+    for (size_t i = 0; i < entries / 10; i++) {
+        list.addRecord(nameFor(entries + i, 0), DOCUMENT, i, 0, static_cast<time_t>(i));
+    }
+    for (size_t i = 0; i < entries / 10; i++) {
+        list.removeNode(list.tail);
+    }
+
+    // Rename every entry a few times; the old names become dead arena bytes
+    size_t peakReserved = 0;
+    for (int generation = 1; generation <= 3; generation++) {
+        size_t i = 0;
+        for (FileNode* current = list.head; current; current = current->next, i++) {
+            list.renameFile(current, nameFor(i, generation));
+        }
+        peakReserved = max(peakReserved, list.names.reservedBytes());
+    }
+    size_t deadBefore = list.names.deadBytes;
+    bool compact = list.names.needsCompaction();
+    if (compact) list.compactNames();
+
+    report("load", list.loadAllocations);
+    report("add", list.addAllocations);
+    report("remove", list.removeAllocations);
+    report("rename", list.renameAllocations);
+    cout << "name arena: " << peakReserved << " bytes reserved with " << deadBefore << " dead; "
+         << (compact ? "compacted to " : "not compacted, ") << list.names.reservedBytes() << " bytes\n";
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Extension classifications per second: getFileTypeFromExtension's perfect
+// hash against the lowercased-substring map lookup it replaced (with the map
+// holding the same extensions, and without the directory stat), and against
+// an unordered_map keyed the same way.
+//
+//   g++ -std=c++17 -O2 -pthread bench/extension_table_bench.cpp -o extension_table_bench
+//   ./extension_table_bench [classifications]   (default 20000000)
+#define FM_NO_MAIN
+#include "../File Management System.cpp"
+
+#include <chrono>
+#include <random>
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// The old lookup: copy the extension with its dot, lowercase it, search the map
+template <typename Map>
+static FileType lookupLowercased(const Map& types, const string& filename) {
+    size_t dotPos = filename.find_last_of('.');
+    if (dotPos != string::npos) {
+        string ext = filename.substr(dotPos);
+        transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        auto it = types.find(ext);
+        if (it != types.end()) return it->second;
+    }
+    return OTHER;
+}
+
+template <typename Classify>
+static void report(const char* label, const vector<string>& names, size_t classifications,
+                   Classify classify, size_t& checksum) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < classifications; i++) {
+        checksum += classify(names[i & (names.size() - 1)]);
+    }
+    double elapsed = secondsSince(start);
+    cout << left << setw(18) << label << right << fixed << setprecision(1) << setw(10)
+         << classifications / elapsed / 1e6 << " M/s" << setw(10) << elapsed * 1e9 / classifications
+         << " ns\n";
+}
+
+int main(int argc, char** argv) {
+    size_t classifications = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+
+    map<string, FileType> ordered;
+    unordered_map<string, FileType> hashed;
+    for (const ExtensionType& entry : EXTENSION_TYPES) {
+        ordered.emplace(string(".") + entry.extension, entry.type);
+        hashed.emplace(string(".") + entry.extension, entry.type);
+    }
+
+    // Known extensions in mixed case, unknown ones, and names without any
+    const char* unknown[] = {"bak", "tmp", "o", "so", "dll", "exe", "part", "crdownload"};
+    const char* prefixes[] = {"", "docs/", "home/user/Pictures/2024/", "build\\out\\"};
+    mt19937_64 random(1);
+    vector<string> names(4096);
+    for (string& name : names) {
+        name = string(prefixes[random() % 4]) + "file-" + to_string(random() % 100000);
+        switch (random() % 8) {
+        case 0:
+            name += string(".") + unknown[random() % 8];
+            break;
+        case 1:
+            break;
+        default: {
+            string ext = EXTENSION_TYPES[random() % ExtensionTable::KEYS].extension;
+            if (random() % 4 == 0) transform(ext.begin(), ext.end(), ext.begin(), ::toupper);
+            name += "." + ext;
+        }
+        }
+    }
+
+    // Every method must agree before any of them is timed
+    for (const string& name : names) {
+        FileType type = getFileTypeFromExtension(name);
+        if (type != lookupLowercased(ordered, name) || type != lookupLowercased(hashed, name)) {
+            cerr << "classification mismatch for " << name << "\n";
+            return 1;
+        }
+    }
+
+    size_t checksum = 0;
+    report("perfect hash", names, classifications,
+           [](const string& name) { return getFileTypeFromExtension(name); }, checksum);
+    report("map", names, classifications,
+           [&](const string& name) { return lookupLowercased(ordered, name); }, checksum);
+    report("unordered_map", names, classifications,
+           [&](const string& name) { return lookupLowercased(hashed, name); }, checksum);
+    cout << "checksum " << checksum << "\n";
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Filename lookup cost as the catalog grows from 1k to 1M entries:
+// FileNameIndex hits and misses against the head-to-tail walk it replaced.
+//
+//   g++ -std=c++17 -O2 -pthread bench/name_index_bench.cpp -o name_index_bench
+#define FM_NO_MAIN
+#include "../File Management System.cpp"
+
+#include <chrono>
+#include <random>
+
+static double nanosPer(chrono::steady_clock::time_point start, size_t operations) {
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / operations;
+}
+
+int main() {
+    const size_t LOOKUPS = 1000000;
+    const size_t WALK_LOOKUPS = 2000; // The walk is O(n); keep the 1M run short
+
+    cout << setw(9) << "entries" << setw(14) << "hit ns" << setw(14) << "miss ns"
+         << setw(14) << "walk ns" << "\n";
+
+    for (size_t entries = 1000; entries <= 1000000; entries *= 10) {
+        StringArena names;
+        NodePool pool;
+        FileNameIndex index;
+        vector<FileNode*> nodes;
+        nodes.reserve(entries);
+        for (size_t i = 0; i < entries; i++) {
+            string name = "docs/project-" + to_string(i * 7919 % entries) + "/report.txt";
+            FileNode* node = pool.create(names.intern(name), DOCUMENT, 0, 0, 0);
+            if (!nodes.empty()) {
+                nodes.back()->next = node;
+            }
+            nodes.push_back(node);
+            index.insert(node);
+        }
+
+        mt19937_64 random(entries);
+        vector<string> hits, misses;
+        for (size_t i = 0; i < 4096; i++) {
+            hits.emplace_back(nodes[random() % entries]->filename);
+            misses.push_back("docs/missing-" + to_string(random()) + "/report.txt");
+        }
+
+        size_t found = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < LOOKUPS; i++) {
+            found += index.find(hits[i & 4095]) != nullptr;
+        }
+        double hitNanos = nanosPer(start, LOOKUPS);
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < LOOKUPS; i++) {
+            found += index.find(misses[i & 4095]) != nullptr;
+        }
+        double missNanos = nanosPer(start, LOOKUPS);
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < WALK_LOOKUPS; i++) {
+            const string& name = hits[i & 4095];
+            for (FileNode* current = nodes.front(); current; current = current->next) {
+                if (current->filename == name) {
+                    found++;
+                    break;
+                }
+            }
+        }
+        double walkNanos = nanosPer(start, WALK_LOOKUPS);
+
+        cout << setw(9) << entries << fixed << setprecision(1) << setw(14) << hitNanos
+             << setw(14) << missNanos << setw(14) << walkNanos << "\n";
+        if (found != LOOKUPS + WALK_LOOKUPS) {
+            cerr << "lookup mismatch\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Random-position inserts and deletes: PositionIndex on its own, FileList's
+// positional add/remove (which also maintain the name and stats indexes),
+// and the head walk that positional operations used before, on a smaller
+// list since it is quadratic.
+//
+//   g++ -std=c++17 -O2 -pthread bench/position_index_bench.cpp -o position_index_bench
+//   ./position_index_bench [entries]   (default 1000000)
+#define FM_NO_MAIN
+#include "../File Management System.cpp"
+
+#include <chrono>
+#include <random>
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Treap alone: nodes come from the pool with no other index to maintain
+static void benchTreap(size_t entries) {
+    StringArena names;
+    NodePool pool;
+    PositionIndex positions;
+    mt19937_64 random(1);
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < entries; i++) {
+        FileNode* node = pool.create(names.intern("n"), DOCUMENT, 0, 0, 0);
+        positions.insert(node, static_cast<int>(random() % (i + 1)));
+    }
+    double insertTime = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t left = entries; left > 0; left--) {
+        positions.erase(positions.at(static_cast<int>(random() % left)));
+    }
+    double eraseTime = secondsSince(start);
+
+    cout << "PositionIndex      " << entries << " inserts " << fixed << setprecision(3) << insertTime
+         << " s, " << entries << " deletes " << eraseTime << " s\n";
+}
+
+// Full FileList path: positional addRecord, then delete by position
+static void benchFileList(size_t entries, size_t deletes) {
+    FileList list;
+    mt19937_64 random(2);
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < entries; i++) {
+        list.addRecord("file-" + to_string(i), DOCUMENT, random() % 4096, 0, static_cast<time_t>(i),
+                       static_cast<int>(random() % (i + 1)));
+    }
+    double insertTime = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < deletes; i++) {
+        list.removeNode(list.getFileNode(static_cast<int>(random() % list.size())));
+    }
+    double deleteTime = secondsSince(start);
+
+    cout << "FileList           " << entries << " inserts " << fixed << setprecision(3) << insertTime
+         << " s, " << deletes << " deletes " << deleteTime << " s\n";
+}
+
+// What positional inserts and deletes cost when they walked from the head
+static void benchHeadWalk(size_t entries) {
+    StringArena names;
+    NodePool pool;
+    FileNode* head = nullptr;
+    size_t count = 0;
+    mt19937_64 random(3);
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < entries; i++) {
+        FileNode* node = pool.create(names.intern("n"), DOCUMENT, 0, 0, 0);
+        size_t position = random() % (count + 1);
+        if (position == 0) {
+            node->next = head;
+            head = node;
+        } else {
+            FileNode* current = head;
+            for (size_t k = 1; k < position; k++) current = current->next;
+            node->next = current->next;
+            current->next = node;
+        }
+        count++;
+    }
+    double insertTime = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    for (; count > 0; count--) {
+        size_t position = random() % count;
+        if (position == 0) {
+            head = head->next;
+        } else {
+            FileNode* current = head;
+            for (size_t k = 1; k < position; k++) current = current->next;
+            current->next = current->next->next;
+        }
+    }
+    double eraseTime = secondsSince(start);
+
+    cout << "head walk          " << entries << " inserts " << fixed << setprecision(3) << insertTime
+         << " s, " << entries << " deletes " << eraseTime << " s\n";
+}
+
+int main(int argc, char** argv) {
+    size_t entries = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    benchTreap(entries);
+    benchFileList(entries, entries / 10);
+    benchHeadWalk(min<size_t>(entries, 20000));
+    return 0;
+}
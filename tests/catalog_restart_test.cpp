@@ -0,0 +1,98 @@
+// Restarts against a catalog store in a scratch directory: a first session
+// that never wrote a snapshot, and a snapshot that can no longer be read.
+// Exits non-zero on the first failed check.
+//
+//   g++ -std=c++17 -pthread tests/catalog_restart_test.cpp -o catalog_restart_test
+//   ./catalog_restart_test
+#define FM_NO_MAIN
+#include "../File Management System.cpp"
+
+static int failures = 0;
+
+static void check(bool condition, const string& what) {
+    if (!condition) {
+        cerr << "FAILED: " << what << "\n";
+        failures++;
+    }
+}
+
+// A process start as main does it
+static void start(FileManager& fm) {
+    fm.recoverFromCrash();
+    fm.loadFiles();
+}
+
+static string readAll(const string& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+// No catalog.bin and no files.txt: every change of the first session lives
+// only in the journal and must survive the restart and a later compaction
+static void firstSessionWithoutSnapshot() {
+    {
+        FileManager fm;
+        start(fm);
+        fm.createFile("a.txt");
+        fm.createFile("d.txt");
+        fm.createDirectory("dir1");
+        fm.createFile("x.bin");
+        fm.updateFileName("d.txt", "e.txt");
+    }
+    check(!fs::exists("catalog.bin"), "first session wrote no snapshot");
+    check(fs::exists("catalog.journal"), "first session wrote a journal");
+
+    {
+        FileManager fm;
+        start(fm);
+        check(fm.fileList.size() == 4, "restart restores every entry from the journal");
+        check(fm.fileList.contains("a.txt") && fm.fileList.contains("e.txt") &&
+              fm.fileList.contains("dir1") && fm.fileList.contains("x.bin") && !fm.fileList.contains("d.txt"),
+              "restart replays the rename");
+        fm.saveFiles();
+    }
+
+    FileManager fm;
+    start(fm);
+    check(fm.fileList.size() == 4, "entries survive compaction into a snapshot");
+}
+
+// A snapshot that fails to parse is moved aside with its journal, never
+// overwritten by the next save
+static void unreadableSnapshot() {
+    string damaged = readAll("catalog.bin");
+    damaged.resize(damaged.size() - 3);
+    {
+        ofstream out("catalog.bin", ios::binary | ios::trunc);
+        out << damaged;
+    }
+
+    {
+        FileManager fm;
+        start(fm);
+        check(fm.fileList.size() == 0, "an unreadable snapshot loads as an empty catalog");
+        check(fs::exists("catalog.bin.corrupt"), "the unreadable snapshot is moved aside");
+        fm.createFile("new.txt");
+        fm.saveFiles();
+    }
+    check(readAll("catalog.bin.corrupt") == damaged, "the moved snapshot is kept byte for byte");
+
+    FileManager fm;
+    start(fm);
+    check(fm.fileList.size() == 1 && fm.fileList.contains("new.txt"), "the new catalog holds only new entries");
+}
+
+int main() {
+    fs::path scratch = fs::temp_directory_path() / ("catalog_restart_test." + to_string(getpid()));
+    fs::create_directories(scratch);
+    fs::path previous = fs::current_path();
+    fs::current_path(scratch);
+
+    firstSessionWithoutSnapshot();
+    unreadableSnapshot();
+
+    fs::current_path(previous);
+    fs::remove_all(scratch);
+    cout << (failures ? "catalog restart test failed\n" : "catalog restart test passed\n");
+    return failures ? 1 : 0;
+}